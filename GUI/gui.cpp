@@ -9,6 +9,9 @@
 #include "../sceneSetUp/volume.h"
 #include "../utils/material.h"
 #include "../simulations/simulations.h"
+#include "simWorker.h"
+#include "particleRenderer.h"
+#include "statsPanel.h"
 
 
 void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Material>& materials) {
@@ -16,7 +19,7 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
     sf::RenderWindow window(sf::VideoMode(windowX, windowY), "My 2D Scene");
     window.setFramerateLimit(0);
     sf::Clock clock;
-    const sf::Time frameDuration = sf::seconds(1.f / 30.f);
+    const sf::Time frameDuration = sf::seconds(1.f / 60.f);
 
     constexpr float panelWidth = 200.0f;
     const float simWidth = windowX - panelWidth;  // Available width for simulation
@@ -35,15 +38,18 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
 
     setUpScene(scene, materials);
 
-    Simulation sim(50000, materials, scene);
+    Simulation sim(numNeutrons, materials, scene);
     sim.isotropicNeutronDirections();
-    std::vector neutronPositions(50000, TwoVec{0.0, 0.0});
-    std::vector<char> alive(50000, 1);
 
-    constexpr float neutronRadius = 3.0f; // pixels
-    sf::CircleShape neutronShape(neutronRadius);
-    neutronShape.setOrigin(neutronRadius, neutronRadius);
-    neutronShape.setFillColor(sf::Color::White);
+    // The simulation steps on its own thread, the render loop only reads its snapshots
+    SimWorker worker(sim);
+    worker.setMaxStepRate(maxStepRate);
+    worker.start();
+
+    ParticleRenderer particles(simWidth, windowY);
+    StatsPanel stats(font, windowX - panelWidth + 20, 120, panelWidth - 40, 100, numNeutrons);
+    bool infoDirty = true;
+    bool shownFinished = false;
 
     // Create the main simulation view - this will be constrained to the simulation area
     sf::View simView(sf::FloatRect(0, 0, simWidth, windowY));
@@ -53,7 +59,6 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
     sf::Vector2f oldPos;
     bool moving = false;
     float zoom = 1;
-    bool runSim = true;
 
     while (window.isOpen()) {
         clock.restart();
@@ -61,6 +66,7 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
         // Handle events
         sf::Event event;
         while (window.pollEvent(event)) {
+            infoDirty = true;
             switch (event.type) {
                 case sf::Event::Closed:
                     window.close();
@@ -120,13 +126,23 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
                 }
                 case sf::Event::KeyPressed:
                     if (event.key.code == sf::Keyboard::Space)
-                        runSim = !runSim;
+                        worker.setPaused(!worker.isPaused());
+                    else if (event.key.code == sf::Keyboard::H)
+                        particles.nextMode();
                 break;
 
                 default: break;
             }
         }
 
+        const SimSnapshot& snapshot = worker.latest();
+        if (snapshot.finished != shownFinished) {
+            shownFinished = snapshot.finished;
+            infoDirty = true;
+        }
+        const auto& neutronPositions = snapshot.positions;
+        const auto& alive = snapshot.alive;
+
         window.clear(sf::Color::Black);
 
         // Set the simulation view for drawing the main scene
@@ -136,30 +152,24 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
         for (const auto& shape : shapes)
             window.draw(*shape);
 
-        // Draw neutrons
-        for (std::size_t i = 0; i < neutronPositions.size(); ++i) {
-            if (alive[i]) {
-                auto& pos = neutronPositions[i];
-                // Adjust neutron positioning for the simulation area
-                const float cameraX = pos.x * 10 + simWidth / 2.0f;
-                const float cameraY = windowY / 2.0f - pos.y * 10;
+        // Draw neutrons, a single draw call either way
+        particles.draw(window, simView, neutronPositions, alive);
 
-                neutronShape.setPosition(cameraX, cameraY);
-                window.draw(neutronShape);
-            }
-        }
+        // Panel text is only rebuilt when something it shows has changed
+        if (stats.sample(snapshot.counters, snapshot.taken) || infoDirty) {
+            // Get centre of the current simulation view
+            sf::Vector2f centre = simView.getCenter();
 
-        // Get centre of the current simulation view
-        sf::Vector2f centre = simView.getCenter();
+            std::ostringstream ss;
+            ss << "Zoom: " << zoom << "\n"
+               << "Centre: (" << centre.x << ", " << centre.y << ")\n"
+               << "Running: " << (snapshot.finished ? "Finished\n" : worker.isPaused() ? "No\n" : "Yes\n")
+               << "View: " << (particles.showingHeatmap() ? "Heatmap" : "Particles")
+               << (particles.getMode() == RENDER_AUTO ? " (auto)\n" : "\n");
 
-        // Build info string
-        std::ostringstream ss;
-        ss << "Zoom: " << zoom << "\n"
-           << "Centre: (" << centre.x << ", " << centre.y << ")\n"
-           << "Running: " << (runSim ? "Yes\n" : "No\n")
-           << "Absorbed: " << sim.getNumAbsorbed() << '\n';
-
-        infoText.setString(ss.str());
+            infoText.setString(ss.str());
+            infoDirty = false;
+        }
 
         // Switch to the default view for UI elements (side panel)
         window.setView(window.getDefaultView());
@@ -167,16 +177,10 @@ void GUI::setUp(const std::vector<const Volume*>& scene, const std::vector<Mater
         // Draw UI elements
         window.draw(sidePanel);
         window.draw(infoText);
+        stats.draw(window);
 
         window.display();
 
-        if (runSim) {
-            // Advance simulation and get results
-            sim.step();
-            neutronPositions = sim.getNeutronPositions();
-            alive = sim.getAliveNeutrons();
-        }
-
         // --- Frame limiting ---
         sf::Time elapsed = clock.getElapsedTime();
 
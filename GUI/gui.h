@@ -43,6 +43,12 @@ public:
 
 
     void setUp(const std::vector<const Volume*>& scene, const std::vector<Material>& materials);
+
+    // Number of neutrons in the visualised run, large runs switch to the density heatmap
+    void setNumNeutrons(const size_t count) { numNeutrons = count; }
+
+    // Caps how many simulation steps run per second, 0 lets the simulation run as fast as it can
+    void setMaxStepRate(const double stepsPerSecond) { maxStepRate = stepsPerSecond; }
     void init() {
         if (!font.loadFromFile("../arial.ttf"))
             throw std::runtime_error("Could not load font");
@@ -79,6 +85,8 @@ public:
 private:
     size_t windowX;
     size_t windowY;
+    size_t numNeutrons{ 50000 };
+    double maxStepRate{ 0.0 };
     sf::Font font;
     std::vector<std::unique_ptr<sf::Shape>> shapes;
 };
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "particleRenderer.h"
+
+#include <cmath>
+#include <algorithm>
+#include <SFML/Graphics.hpp>
+
+#include "../utils/types.h"
+
+
+void ParticleRenderer::draw(sf::RenderWindow& window, const sf::View& view,
+                            const std::vector<TwoVec>& positions, const std::vector<char>& alive) {
+    heatmapActive = mode == RENDER_HEATMAP || (mode == RENDER_AUTO && positions.size() > heatmapThreshold);
+
+    if (heatmapActive) drawHeatmap(window, view, positions, alive);
+    else drawParticles(window, positions, alive);
+}
+
+void ParticleRenderer::drawParticles(sf::RenderWindow& window, const std::vector<TwoVec>& positions,
+                                     const std::vector<char>& alive) {
+    const size_t aliveCount = std::count(alive.begin(), alive.end(), 1);
+
+    // Shrinking keeps the capacity so the array is only ever reallocated when the run grows
+    vertices.resize(4 * aliveCount);
+
+    size_t v{};
+    for (size_t i{}; i < positions.size(); i++) {
+        if (!alive[i]) continue;
+
+        const float x{ cameraX(positions[i].x) };
+        const float y{ cameraY(positions[i].y) };
+
+        vertices[v++] = sf::Vertex(sf::Vector2f(x - neutronRadius, y - neutronRadius), sf::Color::White);
+        vertices[v++] = sf::Vertex(sf::Vector2f(x + neutronRadius, y - neutronRadius), sf::Color::White);
+        vertices[v++] = sf::Vertex(sf::Vector2f(x + neutronRadius, y + neutronRadius), sf::Color::White);
+        vertices[v++] = sf::Vertex(sf::Vector2f(x - neutronRadius, y + neutronRadius), sf::Color::White);
+    }
+
+    window.draw(vertices);
+}
+
+void ParticleRenderer::drawHeatmap(sf::RenderWindow& window, const sf::View& view,
+                                   const std::vector<TwoVec>& positions, const std::vector<char>& alive) {
+    // One texel per screen pixel of the simulation area
+    if (texWidth != static_cast<unsigned>(simWidth) || texHeight != static_cast<unsigned>(simHeight)) {
+        texWidth = static_cast<unsigned>(simWidth);
+        texHeight = static_cast<unsigned>(simHeight);
+        texture.create(texWidth, texHeight);
+        sprite.setTexture(texture, true);
+        counts.assign(texWidth * texHeight, 0);
+        pixels.assign(4 * texWidth * texHeight, 0);
+    }
+
+    const unsigned numThreads{ pool.size() };
+    threadCounts.resize(numThreads);
+    chunkMax.assign(numThreads, 0);
+
+    const sf::Vector2f size{ view.getSize() };
+    const sf::Vector2f centre{ view.getCenter() };
+    const float left{ centre.x - size.x / 2.0f };
+    const float top{ centre.y - size.y / 2.0f };
+    const float scaleX{ texWidth / size.x };
+    const float scaleY{ texHeight / size.y };
+
+    // Every thread bins its share of the particles into a private histogram
+    pool.parallelChunks(positions.size(), [&](const size_t begin, const size_t end, const unsigned t) {
+        auto& local{ threadCounts[t] };
+        local.assign(texWidth * texHeight, 0);
+
+        for (size_t i{ begin }; i < end; i++) {
+            if (!alive[i]) continue;
+
+            const float px{ (cameraX(positions[i].x) - left) * scaleX };
+            const float py{ (cameraY(positions[i].y) - top) * scaleY };
+            if (px < 0.0f || py < 0.0f || px >= texWidth || py >= texHeight) continue;
+
+            local[static_cast<unsigned>(py) * texWidth + static_cast<unsigned>(px)]++;
+        }
+    });
+
+    // Merge the histograms over disjoint pixel ranges
+    pool.parallelChunks(counts.size(), [&](const size_t begin, const size_t end, const unsigned t) {
+        std::uint32_t maxCount{};
+        for (size_t p{ begin }; p < end; p++) {
+            std::uint32_t sum{};
+            for (const auto& local : threadCounts) sum += local[p];
+            counts[p] = sum;
+            maxCount = std::max(maxCount, sum);
+        }
+        chunkMax[t] = maxCount;
+    });
+
+    // Log scaled black -> red -> yellow -> white colour map
+    const double logMax{ std::log1p(static_cast<double>(*std::max_element(chunkMax.begin(), chunkMax.end()))) };
+    pool.parallelChunks(counts.size(), [&](const size_t begin, const size_t end, unsigned) {
+        for (size_t p{ begin }; p < end; p++) {
+            const double level{ logMax > 0.0 ? std::log1p(static_cast<double>(counts[p])) / logMax : 0.0 };
+            pixels[4 * p + 0] = static_cast<sf::Uint8>(255.0 * std::min(1.0, 3.0 * level));
+            pixels[4 * p + 1] = static_cast<sf::Uint8>(255.0 * std::clamp(3.0 * level - 1.0, 0.0, 1.0));
+            pixels[4 * p + 2] = static_cast<sf::Uint8>(255.0 * std::clamp(3.0 * level - 2.0, 0.0, 1.0));
+            pixels[4 * p + 3] = counts[p] ? 255 : 0;
+        }
+    });
+
+    texture.update(pixels.data());
+
+    // The texture covers exactly what the view currently shows
+    sprite.setPosition(left, top);
+    sprite.setScale(1.0f / scaleX, 1.0f / scaleY);
+    window.draw(sprite);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <SFML/Graphics.hpp>
+
+#include "../utils/types.h"
+#include "workerPool.h"
+
+enum RenderMode {
+    RENDER_AUTO=0,      // particles below heatmapThreshold, heatmap above
+    RENDER_PARTICLES=1,
+    RENDER_HEATMAP=2,
+};
+
+// Draws every live neutron with a single draw call. Small runs are drawn as quads from
+// one vertex array updated in place, large runs are binned into a density texture on
+// the CPU, split across a pool of threads kept for the renderer's lifetime, and drawn as
+// one sprite covering the view.
+class ParticleRenderer {
+public:
+    ParticleRenderer(const float simWidth, const float simHeight) : simWidth(simWidth), simHeight(simHeight),
+                                                                    vertices(sf::Quads) {}
+
+    void setMode(const RenderMode m) { mode = m; }
+    RenderMode getMode() const { return mode; }
+
+    // Cycles auto -> particles -> heatmap -> auto
+    void nextMode() { mode = static_cast<RenderMode>((mode + 1) % 3); }
+
+    // Whether the last draw used the heatmap
+    bool showingHeatmap() const { return heatmapActive; }
+
+    void draw(sf::RenderWindow& window, const sf::View& view,
+              const std::vector<TwoVec>& positions, const std::vector<char>& alive);
+
+private:
+    static constexpr size_t heatmapThreshold{ 200000 };
+    static constexpr float neutronRadius{ 3.0f }; // pixels
+
+    // Scene is in cm, the camera in mm with (0,0) in the middle of the simulation area
+    float cameraX(const double x) const { return static_cast<float>(x) * 10.0f + simWidth / 2.0f; }
+    float cameraY(const double y) const { return simHeight / 2.0f - static_cast<float>(y) * 10.0f; }
+
+    void drawParticles(sf::RenderWindow& window, const std::vector<TwoVec>& positions, const std::vector<char>& alive);
+    void drawHeatmap(sf::RenderWindow& window, const sf::View& view,
+                     const std::vector<TwoVec>& positions, const std::vector<char>& alive);
+
+    float simWidth;
+    float simHeight;
+    RenderMode mode{ RENDER_AUTO };
+    bool heatmapActive{ false };
+
+    sf::VertexArray vertices;
+
+    // Heatmap state, all reused between frames
+    unsigned texWidth{};
+    unsigned texHeight{};
+    sf::Texture texture;
+    sf::Sprite sprite;
+    WorkerPool pool;
+    std::vector<std::vector<std::uint32_t>> threadCounts;
+    std::vector<std::uint32_t> chunkMax;
+    std::vector<std::uint32_t> counts;
+    std::vector<sf::Uint8> pixels;
+};
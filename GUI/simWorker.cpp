@@ -0,0 +1,69 @@
+#include "simWorker.h"
+
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "../simulations/simulations.h"
+
+
+void SimWorker::start() {
+    if (thread.joinable()) return;
+
+    quit.store(false);
+    publish();
+    thread = std::thread(&SimWorker::run, this);
+}
+
+void SimWorker::stop() {
+    quit.store(true);
+    if (thread.joinable()) thread.join();
+}
+
+void SimWorker::run() {
+    using Clock = std::chrono::steady_clock;
+    auto nextStep{ Clock::now() };
+    bool wasPaused{ false };
+
+    while (!quit.load(std::memory_order_relaxed)) {
+        if (paused.load(std::memory_order_relaxed)) {
+            // Make sure the renderer sees the state we paused on
+            if (!wasPaused) publish();
+            wasPaused = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            nextStep = Clock::now();
+            continue;
+        }
+        wasPaused = false;
+
+        const double rate{ maxStepRate.load(std::memory_order_relaxed) };
+        if (rate > 0.0) {
+            // Do not try to catch up on steps missed while unlimited or slow
+            nextStep = std::max(nextStep, Clock::now());
+            std::this_thread::sleep_until(nextStep);
+            nextStep += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+        }
+
+        sim.step();
+
+        // Once every neutron is gone further steps change nothing, hand over the final state and finish
+        if (sim.getCounters().alive == 0) {
+            publish(true);
+            return;
+        }
+
+        // Only copy the particles out once the renderer has picked up the previous snapshot
+        if (!(middle.load(std::memory_order_relaxed) & dirtyBit))
+            publish();
+    }
+}
+
+void SimWorker::publish(const bool finished) {
+    SimSnapshot& snap{ buffers[back] };
+    sim.copyState(snap.positions, snap.alive);
+    snap.counters = sim.getCounters();
+    snap.taken = std::chrono::steady_clock::now();
+    snap.finished = finished;
+
+    back = middle.exchange(back | dirtyBit, std::memory_order_acq_rel) & indexMask;
+}
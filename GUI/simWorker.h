@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../utils/types.h"
+#include "../simulations/simulations.h"
+
+// State of the simulation as seen by the renderer
+struct SimSnapshot {
+    std::vector<TwoVec> positions;
+    std::vector<char> alive;
+    SimCounters counters{};
+    std::chrono::steady_clock::time_point taken{};
+    bool finished{ false };     // final state, the worker has stopped stepping
+};
+
+// Runs a Simulation on its own thread as fast as allowed and hands snapshots to the
+// render thread through a lock-free triple buffer: the worker always owns one slot, the
+// renderer another, and the third is swapped atomically between them, so neither side
+// ever waits for the other. The simulation must only be touched through the worker
+// while it is running. Once no neutron is left alive the worker publishes the final
+// state and its thread ends.
+class SimWorker {
+public:
+    explicit SimWorker(Simulation& sim) : sim(sim), middle(1), back(0), front(2),
+                                          paused(false), quit(false), maxStepRate(0.0) {}
+
+    ~SimWorker() { stop(); }
+
+    SimWorker(const SimWorker&) = delete;
+    SimWorker& operator=(const SimWorker&) = delete;
+
+    void start();
+    void stop();
+
+    // Control channel, safe to call from the render thread
+    void setPaused(const bool p) { paused.store(p, std::memory_order_relaxed); }
+    bool isPaused() const { return paused.load(std::memory_order_relaxed); }
+
+    // Steps per second, 0 means unlimited
+    void setMaxStepRate(const double stepsPerSecond) { maxStepRate.store(stepsPerSecond, std::memory_order_relaxed); }
+
+    // Swaps in the newest published snapshot if there is one, render thread only
+    const SimSnapshot& latest() {
+        if (middle.load(std::memory_order_relaxed) & dirtyBit)
+            front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return buffers[front];
+    }
+
+private:
+    static constexpr unsigned dirtyBit{ 4 };
+    static constexpr unsigned indexMask{ 3 };
+
+    void run();
+    void publish(bool finished = false);
+
+    Simulation& sim;
+
+    std::array<SimSnapshot, 3> buffers;
+    std::atomic<unsigned> middle;
+    unsigned back;   // worker thread only
+    unsigned front;  // render thread only
+
+    std::atomic<bool> paused;
+    std::atomic<bool> quit;
+    std::atomic<double> maxStepRate;
+    std::thread thread;
+};
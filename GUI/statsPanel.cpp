@@ -0,0 +1,111 @@
+#include "statsPanel.h"
+
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <SFML/Graphics.hpp>
+
+
+StatsPanel::StatsPanel(const sf::Font& font, const float x, const float y, const float width,
+                       const float graphHeight, const size_t numNeutrons)
+: x(x), y(y), width(width), graphHeight(graphHeight), numNeutrons(numNeutrons),
+  graphFrame(sf::Vector2f(width, graphHeight)), graph(sf::LineStrip) {
+
+    text.setFont(font);
+    text.setCharacterSize(14);
+    text.setFillColor(sf::Color::Black);
+    text.setPosition(x, y);
+
+    // Graph sits at the bottom of the stats block
+    graphFrame.setPosition(x, y + 120.0f);
+    graphFrame.setFillColor(sf::Color(96, 96, 96, 255));
+    graphFrame.setOutlineColor(sf::Color::Black);
+    graphFrame.setOutlineThickness(1.0f);
+}
+
+bool StatsPanel::sample(const SimCounters& counters, const std::chrono::steady_clock::time_point taken) {
+    const auto now{ std::chrono::steady_clock::now() };
+
+    if (!hasLast) {
+        last = counters;
+        lastTaken = taken;
+        lastRefresh = now;
+        hasLast = true;
+        rebuild(counters);
+        return true;
+    }
+
+    if (std::chrono::duration<double>(now - lastRefresh).count() < refreshSeconds) return false;
+    lastRefresh = now;
+
+    // Snapshot times, not frame times, so rates stay right however often the renderer picks them up
+    const double dt{ std::chrono::duration<double>(taken - lastTaken).count() };
+    if (dt > 0.0) {
+        const size_t finished{ counters.absorbed + counters.leaked - last.absorbed - last.leaked };
+        historiesPerSec = finished / dt;
+        collisionsPerSec = (counters.collisions - last.collisions) / dt;
+    }
+    else {
+        // Nothing new was published, the worker is paused or done
+        historiesPerSec = 0.0;
+        collisionsPerSec = 0.0;
+    }
+
+    last = counters;
+    lastTaken = taken;
+
+    history[historyHead] = historiesPerSec;
+    historyHead = (historyHead + 1) % historyLength;
+    historyCount = std::min(historyCount + 1, historyLength);
+
+    rebuild(counters);
+    return true;
+}
+
+void StatsPanel::rebuild(const SimCounters& counters) {
+    // Binomial standard error of a fraction of the finished histories
+    const size_t finished{ counters.absorbed + counters.leaked };
+    auto fraction = [finished](const size_t k, double& err) {
+        if (finished == 0) { err = 0.0; return 0.0; }
+        const double p{ static_cast<double>(k) / finished };
+        err = std::sqrt(p * (1.0 - p) / finished);
+        return p;
+    };
+
+    double absErr{};
+    double leakErr{};
+    const double absFrac{ fraction(counters.absorbed, absErr) };
+    const double leakFrac{ fraction(counters.leaked, leakErr) };
+
+    std::ostringstream ss;
+    ss << std::setprecision(3)
+       << "Histories/s: " << historiesPerSec << '\n'
+       << "Collisions/s: " << collisionsPerSec << '\n'
+       << "Alive: " << counters.alive << '/' << numNeutrons << '\n'
+       << std::fixed
+       << "Absorbed: " << absFrac << " +- " << absErr << '\n'
+       << "Leaked: " << leakFrac << " +- " << leakErr << '\n'
+       << "Steps: " << counters.steps << '\n';
+    text.setString(ss.str());
+
+    // Throughput graph, oldest sample on the left, scaled to the largest sample shown
+    double peak{};
+    for (size_t i{}; i < historyCount; i++) peak = std::max(peak, history[i]);
+
+    graph.resize(historyCount);
+    const float top{ y + 120.0f };
+    for (size_t i{}; i < historyCount; i++) {
+        const size_t idx{ (historyHead + historyLength - historyCount + i) % historyLength };
+        const float level{ peak > 0.0 ? static_cast<float>(history[idx] / peak) : 0.0f };
+        const float px{ x + width * i / (historyLength - 1) };
+        const float py{ top + graphHeight * (1.0f - level) };
+        graph[i] = sf::Vertex(sf::Vector2f(px, py), sf::Color::Green);
+    }
+}
+
+void StatsPanel::draw(sf::RenderWindow& window) {
+    window.draw(text);
+    window.draw(graphFrame);
+    window.draw(graph);
+}
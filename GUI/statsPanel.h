@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <SFML/Graphics.hpp>
+
+#include "../utils/types.h"
+
+// Live run statistics for the side panel. Rates come from differences between
+// successive snapshots of the simulation counters, and the text is only rebuilt a
+// few times per second instead of every frame.
+class StatsPanel {
+public:
+    StatsPanel(const sf::Font& font, float x, float y, float width, float graphHeight, size_t numNeutrons);
+
+    // Feeds the counters of the latest snapshot, returns true when the text should be rebuilt
+    bool sample(const SimCounters& counters, std::chrono::steady_clock::time_point taken);
+
+    void draw(sf::RenderWindow& window);
+
+private:
+    static constexpr size_t historyLength{ 120 };
+    static constexpr double refreshSeconds{ 0.25 };
+
+    void rebuild(const SimCounters& counters);
+
+    float x;
+    float y;
+    float width;
+    float graphHeight;
+    size_t numNeutrons;
+
+    SimCounters last{};
+    std::chrono::steady_clock::time_point lastTaken{};
+    std::chrono::steady_clock::time_point lastRefresh{};
+    bool hasLast{ false };
+
+    double historiesPerSec{};
+    double collisionsPerSec{};
+
+    // Ring buffer of histories/s for the throughput graph
+    std::array<double, historyLength> history{};
+    size_t historyHead{};
+    size_t historyCount{};
+
+    sf::Text text;
+    sf::RectangleShape graphFrame;
+    sf::VertexArray graph;
+};
@@ -0,0 +1,63 @@
+#include "workerPool.h"
+
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+
+WorkerPool::WorkerPool(const unsigned numThreads) : numThreads(std::max(1u, numThreads)) {
+    for (unsigned t{ 1 }; t < this->numThreads; t++)
+        helpers.emplace_back(&WorkerPool::helper, this, t);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& th : helpers) th.join();
+}
+
+void WorkerPool::parallelChunks(const size_t n, const ChunkFn& fn) {
+    {
+        std::lock_guard lock(mutex);
+        task = &fn;
+        taskSize = n;
+        pending = numThreads - 1;
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunk(n, fn, 0);
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::helper(const unsigned index) {
+    std::uint64_t seen{};
+
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return quit || generation != seen; });
+        if (quit) return;
+        seen = generation;
+
+        const ChunkFn& fn{ *task };
+        const size_t n{ taskSize };
+        lock.unlock();
+        runChunk(n, fn, index);
+        lock.lock();
+
+        if (--pending == 0) done.notify_one();
+    }
+}
+
+void WorkerPool::runChunk(const size_t n, const ChunkFn& fn, const unsigned index) const {
+    const size_t chunk{ (n + numThreads - 1) / numThreads };
+    const size_t begin{ std::min(n, index * chunk) };
+    const size_t end{ std::min(n, begin + chunk) };
+    fn(begin, end, index);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+// Fixed set of helper threads kept for the lifetime of its owner, so per-frame parallel work
+// only wakes threads instead of creating them. The calling thread takes part as thread 0.
+class WorkerPool {
+public:
+    using ChunkFn = std::function<void(size_t begin, size_t end, unsigned thread)>;
+
+    explicit WorkerPool(unsigned numThreads = std::max(1u, std::thread::hardware_concurrency()));
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return numThreads; }
+
+    // Splits [0, n) into one contiguous chunk per thread and returns once every chunk is done
+    void parallelChunks(size_t n, const ChunkFn& fn);
+
+private:
+    void helper(unsigned index);
+    void runChunk(size_t n, const ChunkFn& fn, unsigned index) const;
+
+    unsigned numThreads;
+    std::vector<std::thread> helpers;
+
+    // Current task, guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const ChunkFn* task{ nullptr };
+    size_t taskSize{};
+    std::uint64_t generation{};
+    unsigned pending{};
+    bool quit{ false };
+};
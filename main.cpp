@@ -1,17 +1,25 @@
 #include <iostream>
 #include <random>
+#include <string_view>
 
 #include "utils/mathOps.h"
 #include "utils/timer.h"
 #include "utils/material.h"
 #include "simulations/simulations.h"
+#include "simulations/scheduler.h"
+#include "simulations/validation.h"
+#include "simulations/autoSelect.h"
 
 #include "GUI/gui.h"
 
 // Enabling optimizations enables:
 // - linear instead of trig random vector (so not isotropic)
 // faster log expression
-int main() {
+int main(int argc, char* argv[]) {
+    // Statistical checks of every engine against analytic results, non-zero exit on any failure
+    if (argc > 1 && std::string_view{ argv[1] } == "--validate")
+        return printValidationReport(runValidationSuite()) ? 0 : 1;
+
     const Material water{3.47, 0.642 / 100.0, WATER};
     const Material lead{0.38, 1.389 / 100.0, LEAD};
     const Material graphite{0.40, 0.095 / 100.0, GRAPHITE};
@@ -67,6 +75,38 @@ int main() {
               << ", kWalks/s: " << numNeutrons / t.elapsed() <<'\n';
 
 
+    std::cout << "Work stealing over batches of graphite histories\n";
+
+    const std::vector<Material> graphiteStack{ graphite, graphite };
+    const std::vector<const Volume*> stack{ &slab1, &slab2 };
+    WorkStealingScheduler scheduler{};
+
+    const ScheduledResult scheduled{ scheduler.run(numNeutrons, 42, [&](const size_t count, Pcg32& gen, RunContext& context) {
+        return woodCockSimulation(count, graphiteStack, stack, Source{}, Boundary{}, context, gen);
+    }) };
+    printWorkerStats(scheduled);
+
+    std::cout << "Reflected: " << scheduled.totals.reflected
+              << ", Absorbed: " << scheduled.totals.absorbed
+              << ", Transmitted: " << scheduled.totals.transmitted
+              << ", kWalks/s: " << numNeutrons / (1000.0 * scheduled.wallSeconds) <<'\n';
+
+
+    std::cout << "Automatic engine selection\n";
+
+    const std::vector<Material> waterOnly{ water };
+    const std::vector<const Volume*> waterSlab{ &slab };
+
+    t.reset();
+    const AutoSelectResult selected{ autoSimulation(numNeutrons, waterOnly, waterSlab) };
+    t.display();
+    printAutoSelectReport(selected);
+
+    std::cout << "Leaked: " << selected.totals.reflected
+              << ", Absorbed: " << selected.totals.absorbed
+              << ", kWalks/s: " << numNeutrons / t.elapsed() <<'\n';
+
+
     std::cout << "Now setting up GUI\n";
     GUI gui{ 400, 400 };
 
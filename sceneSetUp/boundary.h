@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../utils/types.h"
+
+// Axis aligned outer domain of the problem. Each side has its own condition:
+// vacuum sides let neutrons escape, reflective sides mirror them back in and
+// periodic sides (which must come in opposite pairs) wrap them to the other side.
+// Reflection and wrapping are applied to the end point of a flight, which is exact
+// for straight flights so both the analog and the Woodcock engines can use it.
+class Boundary {
+public:
+    // Infinite vacuum domain, i.e. no outer boundary at all
+    Boundary() : minCorner(-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()),
+                 maxCorner(std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()),
+                 xLow(VACUUM_BOUNDARY), xHigh(VACUUM_BOUNDARY), yLow(VACUUM_BOUNDARY), yHigh(VACUUM_BOUNDARY) {}
+
+    // Same condition on both sides of each axis
+    Boundary(const TwoVec& minCorner, const TwoVec& maxCorner, const BoundaryCondition xCond, const BoundaryCondition yCond)
+    : Boundary(minCorner, maxCorner, xCond, xCond, yCond, yCond) {}
+
+    Boundary(const TwoVec& minCorner, const TwoVec& maxCorner,
+             const BoundaryCondition xLow, const BoundaryCondition xHigh,
+             const BoundaryCondition yLow, const BoundaryCondition yHigh)
+    : minCorner(minCorner), maxCorner(maxCorner), xLow(xLow), xHigh(xHigh), yLow(yLow), yHigh(yHigh) {
+        if ((xLow == PERIODIC) != (xHigh == PERIODIC) || (yLow == PERIODIC) != (yHigh == PERIODIC))
+            throw std::runtime_error("Periodic boundary sides must come in opposite pairs");
+    }
+
+    // Brings a neutron that flew out of the domain back in, returns false if it escaped through a vacuum side
+    bool apply(TwoVec& pos, TwoVec& dir) const {
+        return applyAxis(pos.x, dir.x, minCorner.x, maxCorner.x, xLow, xHigh) &&
+               applyAxis(pos.y, dir.y, minCorner.y, maxCorner.y, yLow, yHigh);
+    }
+
+    // The default domain, which never changes a flight
+    bool isUnbounded() const {
+        return std::isinf(minCorner.x) && std::isinf(minCorner.y) && std::isinf(maxCorner.x) && std::isinf(maxCorner.y);
+    }
+
+    bool contains(const TwoVec& p) const {
+        return (p.x >= minCorner.x && p.x <= maxCorner.x) && (p.y >= minCorner.y && p.y <= maxCorner.y);
+    }
+
+private:
+    static bool applyAxis(double& pos, double& dir, const double lo, const double hi,
+                          const BoundaryCondition low, const BoundaryCondition high) {
+        const double width{ hi - lo };
+
+        // Flights through vacuum materials are infinite and cannot be folded back, count them as escaped
+        if (!std::isfinite(pos)) return false;
+
+        if (pos >= lo && pos <= hi) return true;
+        if ((pos < lo ? low : high) == VACUUM_BOUNDARY) return false;
+
+        // A long flight can cross the domain many times, so it is folded in one step: count the
+        // widths travelled from lo and keep the remainder. Reflective pairs mirror on odd counts.
+        if (low == high) {
+            const double cells{ std::floor((pos - lo) / width) };
+            const double rest{ std::clamp(pos - lo - cells * width, 0.0, width) };
+            if (low == PERIODIC || std::fmod(cells, 2.0) == 0.0) pos = lo + rest;
+            else {
+                pos = hi - rest;
+                dir = -dir;
+            }
+            return true;
+        }
+
+        // A reflective side facing a vacuum one: mirrored once, the neutron either ends up inside
+        // or carries on out through the vacuum side
+        pos = pos < lo ? 2.0 * lo - pos : 2.0 * hi - pos;
+        dir = -dir;
+        return pos >= lo && pos <= hi;
+    }
+
+    TwoVec minCorner;
+    TwoVec maxCorner;
+
+    BoundaryCondition xLow;
+    BoundaryCondition xHigh;
+    BoundaryCondition yLow;
+    BoundaryCondition yHigh;
+};
@@ -0,0 +1,133 @@
+#include "csg.h"
+
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+
+CSGExpr::CSGExpr(const CSGOp op, const CSGExpr& lhs, const CSGExpr& rhs) {
+    node = std::make_shared<const Node>(Node{op, {}, lhs.node, rhs.node});
+}
+
+CSGExpr CSGExpr::halfPlane(const double a, const double b, const double c) {
+    CSGExpr e;
+    e.node = std::make_shared<const Node>(Node{CSG_HALF_PLANE, {a, b, c, 0.0}, nullptr, nullptr});
+    return e;
+}
+
+CSGExpr CSGExpr::circle(const double radius, const double x, const double y) {
+    CSGExpr e;
+    e.node = std::make_shared<const Node>(Node{CSG_CIRCLE, {x, y, radius * radius, radius}, nullptr, nullptr});
+    return e;
+}
+
+CSGExpr CSGExpr::box(const TwoVec& minCorner, const TwoVec& maxCorner) {
+    CSGExpr e;
+    e.node = std::make_shared<const Node>(Node{CSG_BOX, {minCorner.x, minCorner.y, maxCorner.x, maxCorner.y}, nullptr, nullptr});
+    return e;
+}
+
+CSGExpr CSGExpr::annulus(const double innerRadius, const double outerRadius, const double x, const double y) {
+    return circle(outerRadius, x, y) - circle(innerRadius, x, y);
+}
+
+
+CSGRegion::CSGRegion(const CSGExpr& expr) {
+    int depth{};
+    int maxDepth{};
+    compile(*expr.node, depth, maxDepth);
+
+    if (maxDepth > maxStackDepth)
+        throw std::runtime_error("CSG expression is too deep to evaluate");
+
+    computeBoundingBox();
+
+    // Unbounded regions keep the default centre
+    if (std::isfinite(bbMin.x) && std::isfinite(bbMax.x)) centreX = (bbMin.x + bbMax.x) / 2.0;
+    if (std::isfinite(bbMin.y) && std::isfinite(bbMax.y)) centreY = (bbMin.y + bbMax.y) / 2.0;
+}
+
+// Post-order walk of the expression tree, this is the only recursive part
+void CSGRegion::compile(const CSGExpr::Node& node, int& depth, int& maxDepth) {
+    if (node.lhs) compile(*node.lhs, depth, maxDepth);
+    if (node.rhs) compile(*node.rhs, depth, maxDepth);
+
+    Instruction ins{node.op, {node.params[0], node.params[1], node.params[2], node.params[3]}};
+    program.push_back(ins);
+
+    switch (node.op) {
+        case CSG_HALF_PLANE:
+        case CSG_CIRCLE:
+        case CSG_BOX:
+            depth++;
+            break;
+        case CSG_UNION:
+        case CSG_INTERSECTION:
+        case CSG_DIFFERENCE:
+            depth--;
+            break;
+        case CSG_COMPLEMENT:
+            break;
+    }
+    maxDepth = std::max(maxDepth, depth);
+}
+
+// Runs the program once over boxes instead of bits
+void CSGRegion::computeBoundingBox() {
+    constexpr double inf{ std::numeric_limits<double>::infinity() };
+    struct Box { TwoVec lo; TwoVec hi; };
+    const Box unbounded{ {-inf, -inf}, {inf, inf} };
+
+    std::vector<Box> stack;
+    for (const auto& [op, params] : program) {
+        switch (op) {
+            case CSG_HALF_PLANE: {
+                // Only axis aligned half planes bound anything
+                Box b{ unbounded };
+                const double a{ params[0] };
+                const double bCoeff{ params[1] };
+                const double c{ params[2] };
+                if (bCoeff == 0.0 && a > 0.0) b.hi.x = c / a;
+                if (bCoeff == 0.0 && a < 0.0) b.lo.x = c / a;
+                if (a == 0.0 && bCoeff > 0.0) b.hi.y = c / bCoeff;
+                if (a == 0.0 && bCoeff < 0.0) b.lo.y = c / bCoeff;
+                stack.push_back(b);
+                break;
+            }
+            case CSG_CIRCLE: {
+                const double r{ params[3] };
+                stack.push_back({ {params[0] - r, params[1] - r}, {params[0] + r, params[1] + r} });
+                break;
+            }
+            case CSG_BOX:
+                stack.push_back({ {params[0], params[1]}, {params[2], params[3]} });
+                break;
+            case CSG_UNION: {
+                const Box rhs{ stack.back() };
+                stack.pop_back();
+                Box& lhs{ stack.back() };
+                lhs.lo.update(std::min(lhs.lo.x, rhs.lo.x), std::min(lhs.lo.y, rhs.lo.y));
+                lhs.hi.update(std::max(lhs.hi.x, rhs.hi.x), std::max(lhs.hi.y, rhs.hi.y));
+                break;
+            }
+            case CSG_INTERSECTION: {
+                const Box rhs{ stack.back() };
+                stack.pop_back();
+                Box& lhs{ stack.back() };
+                lhs.lo.update(std::max(lhs.lo.x, rhs.lo.x), std::max(lhs.lo.y, rhs.lo.y));
+                lhs.hi.update(std::min(lhs.hi.x, rhs.hi.x), std::min(lhs.hi.y, rhs.hi.y));
+                break;
+            }
+            case CSG_DIFFERENCE:
+                // A - B is contained in A
+                stack.pop_back();
+                break;
+            case CSG_COMPLEMENT:
+                stack.back() = unbounded;
+                break;
+        }
+    }
+
+    bbMin = stack.back().lo;
+    bbMax = stack.back().hi;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "../utils/types.h"
+#include "volume.h"
+
+enum CSGOp : std::uint8_t {
+    CSG_HALF_PLANE=0,   // a*x + b*y <= c
+    CSG_CIRCLE=1,       // (x-cx)^2 + (y-cy)^2 <= r^2
+    CSG_BOX=2,          // axis aligned box
+    CSG_UNION=3,
+    CSG_INTERSECTION=4,
+    CSG_DIFFERENCE=5,
+    CSG_COMPLEMENT=6,
+};
+
+// Build time description of a CSG region. Expressions are small trees combined
+// with | (union), & (intersection), - (difference) and ~ (complement); they are
+// only walked once, when a CSGRegion compiles them.
+class CSGExpr {
+public:
+    static CSGExpr halfPlane(double a, double b, double c);
+    static CSGExpr circle(double radius, double x, double y);
+    static CSGExpr box(const TwoVec& minCorner, const TwoVec& maxCorner);
+    static CSGExpr annulus(double innerRadius, double outerRadius, double x, double y);
+
+    friend CSGExpr operator|(const CSGExpr& lhs, const CSGExpr& rhs) { return CSGExpr(CSG_UNION, lhs, rhs); }
+    friend CSGExpr operator&(const CSGExpr& lhs, const CSGExpr& rhs) { return CSGExpr(CSG_INTERSECTION, lhs, rhs); }
+    friend CSGExpr operator-(const CSGExpr& lhs, const CSGExpr& rhs) { return CSGExpr(CSG_DIFFERENCE, lhs, rhs); }
+    friend CSGExpr operator~(const CSGExpr& expr) { return CSGExpr(CSG_COMPLEMENT, expr, CSGExpr()); }
+
+private:
+    friend class CSGRegion;
+
+    struct Node {
+        CSGOp op;
+        double params[4];
+        std::shared_ptr<const Node> lhs;
+        std::shared_ptr<const Node> rhs;
+    };
+
+    CSGExpr() = default;
+    CSGExpr(CSGOp op, const CSGExpr& lhs, const CSGExpr& rhs);
+
+    std::shared_ptr<const Node> node;
+};
+
+// A region compiled to a flat postfix program. Membership is evaluated in a single
+// loop over the instructions with a bit stack (one bit per pending operand), so there
+// is no recursion and no virtual call per primitive. A bounding box computed at
+// compile time rejects most points before the program runs.
+class CSGRegion final : public Volume {
+public:
+    explicit CSGRegion(const CSGExpr& expr);
+
+    bool contains(const TwoVec& p) const override {
+        if (p.x < bbMin.x || p.x > bbMax.x || p.y < bbMin.y || p.y > bbMax.y) return false;
+
+        std::uint64_t stack{};
+        for (const auto& [op, params] : program) {
+            switch (op) {
+                case CSG_HALF_PLANE:
+                    stack = (stack << 1) | (params[0] * p.x + params[1] * p.y <= params[2]);
+                    break;
+                case CSG_CIRCLE: {
+                    const double dx{ p.x - params[0] };
+                    const double dy{ p.y - params[1] };
+                    stack = (stack << 1) | (dx * dx + dy * dy <= params[2]);
+                    break;
+                }
+                case CSG_BOX:
+                    stack = (stack << 1) | (p.x >= params[0] && p.x <= params[2] && p.y >= params[1] && p.y <= params[3]);
+                    break;
+                case CSG_UNION: {
+                    const std::uint64_t top{ stack & 1 };
+                    stack = (stack >> 1) | top;
+                    break;
+                }
+                case CSG_INTERSECTION: {
+                    const std::uint64_t top{ stack & 1 };
+                    stack = (stack >> 1) & (~1ull | top);
+                    break;
+                }
+                case CSG_DIFFERENCE: {
+                    const std::uint64_t top{ stack & 1 };
+                    stack = (stack >> 1) & (~1ull | (top ^ 1));
+                    break;
+                }
+                case CSG_COMPLEMENT:
+                    stack ^= 1;
+                    break;
+            }
+        }
+        return stack & 1;
+    }
+
+    ShapeType shapeType() const override { return CSG; }
+
+    // Renders as its bounding box
+    RenderInfo renderInfo() const override {
+        return {CSG, bbMax.x - bbMin.x, bbMax.y - bbMin.y, centreX, centreY};
+    }
+
+    TwoVec boundingBoxMin() const { return bbMin; }
+    TwoVec boundingBoxMax() const { return bbMax; }
+
+private:
+    struct Instruction {
+        CSGOp op;
+        double params[4];
+    };
+
+    // Every leaf pushes one bit, so the stack can hold at most 64 pending operands
+    static constexpr int maxStackDepth{ 64 };
+
+    void compile(const CSGExpr::Node& node, int& depth, int& maxDepth);
+    void computeBoundingBox();
+
+    std::vector<Instruction> program;
+    TwoVec bbMin;
+    TwoVec bbMax;
+};
@@ -0,0 +1,78 @@
+#include "lattice.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+
+RectLattice::RectLattice(const TwoVec& minCorner, const double pitch, const int nx, const int ny,
+                         const std::vector<const Universe*>& universes, const std::vector<std::uint8_t>& layout)
+: Volume(minCorner.x + nx * pitch / 2.0, minCorner.y + ny * pitch / 2.0),
+  minCorner(minCorner), maxCorner(minCorner.x + nx * pitch, minCorner.y + ny * pitch),
+  pitch(pitch), invPitch(1.0 / pitch), nx(nx), ny(ny), universes(universes), layout(layout) {
+
+    if (layout.size() != static_cast<size_t>(nx * ny))
+        throw std::runtime_error("Lattice layout does not match its dimensions");
+    for (const auto u : layout)
+        if (u >= universes.size())
+            throw std::runtime_error("Lattice layout refers to a missing universe");
+
+    nested = true;
+}
+
+const Material* RectLattice::materialAt(const TwoVec& p) const {
+    if (!contains(p)) return nullptr;
+
+    // Clamp so points exactly on the outer edge land in the last cell
+    const int ix{ std::clamp(static_cast<int>((p.x - minCorner.x) * invPitch), 0, nx - 1) };
+    const int iy{ std::clamp(static_cast<int>((p.y - minCorner.y) * invPitch), 0, ny - 1) };
+
+    const TwoVec local{ p.x - (minCorner.x + (ix + 0.5) * pitch), p.y - (minCorner.y + (iy + 0.5) * pitch) };
+    return &universes[layout[ix + nx * iy]]->materialAt(local);
+}
+
+double RectLattice::majorantCrossSec() const {
+    double majorant{};
+    for (const auto u : universes)
+        majorant = std::max(majorant, u->majorantCrossSec());
+    return majorant;
+}
+
+
+HexLattice::HexLattice(const TwoVec& centre, const double pitch, const int rings, const Universe& universe)
+: Volume(centre.x, centre.y), pitch(pitch), rings(rings), universe(&universe) {
+    nested = true;
+}
+
+// Axial coordinates: cell (q, r) is centred at (pitch * (q + r / 2), pitch * sqrt(3) / 2 * r)
+void HexLattice::cellOf(const TwoVec& p, int& q, int& r) const {
+    const double rowHeight{ pitch * std::sqrt(3.0) / 2.0 };
+    const double fr{ (p.y - centreY) / rowHeight };
+    const double fq{ (p.x - centreX) / pitch - fr / 2.0 };
+    const double fs{ -fq - fr };
+
+    // Cube rounding: round all three and fix the one that moved the most
+    double rq{ std::round(fq) };
+    double rr{ std::round(fr) };
+    const double rs{ std::round(fs) };
+
+    const double dq{ std::abs(rq - fq) };
+    const double dr{ std::abs(rr - fr) };
+    const double ds{ std::abs(rs - fs) };
+
+    if (dq > dr && dq > ds) rq = -rr - rs;
+    else if (dr > ds) rr = -rq - rs;
+
+    q = static_cast<int>(rq);
+    r = static_cast<int>(rr);
+}
+
+const Material* HexLattice::materialAt(const TwoVec& p) const {
+    int q{};
+    int r{};
+    cellOf(p, q, r);
+    if (hexDistance(q, r) >= rings) return nullptr;
+
+    const TwoVec local{ p.x - (centreX + pitch * (q + r / 2.0)), p.y - (centreY + pitch * std::sqrt(3.0) / 2.0 * r) };
+    return &universe->materialAt(local);
+}
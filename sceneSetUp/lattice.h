@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../utils/types.h"
+#include "../utils/material.h"
+#include "volume.h"
+
+// Contents of one lattice cell, in coordinates local to the cell centre.
+// Volumes are matched first-hit-wins like a scene, anything else is filled with the background material.
+// Lattices do not nest: a universe only looks at its volumes' shapes, so it rejects nested volumes.
+class Universe {
+public:
+    Universe(const std::vector<const Volume*>& volumes, const std::vector<Material>& materials, const Material& fill)
+    : volumes(volumes), materials(materials), fill(fill) {
+        if (volumes.size() != materials.size())
+            throw std::runtime_error("Universe needs one material per volume");
+        for (const auto vol : volumes)
+            if (vol->isNested()) throw std::runtime_error("Universes cannot contain nested volumes");
+    }
+
+    const Material& materialAt(const TwoVec& local) const {
+        for (size_t j{}; j < volumes.size(); j++)
+            if (volumes[j]->contains(local)) return materials[j];
+        return fill;
+    }
+
+    double majorantCrossSec() const {
+        double majorant{ fill.getCrossSec() };
+        for (const auto& m : materials)
+            majorant = std::max(majorant, m.getCrossSec());
+        return majorant;
+    }
+
+private:
+    std::vector<const Volume*> volumes;
+    std::vector<Material> materials;
+    Material fill;
+};
+
+// nx by ny square cells of side pitch starting at minCorner. Every cell delegates to a
+// universe picked from a shared list, so a 17x17 assembly costs one byte per cell and the
+// position -> cell lookup is two floors no matter how large the lattice is.
+// Universes must outlive the lattice.
+class RectLattice final : public Volume {
+public:
+    // Every cell holds the same universe
+    RectLattice(const TwoVec& minCorner, const double pitch, const int nx, const int ny, const Universe& universe)
+    : RectLattice(minCorner, pitch, nx, ny, {&universe}, std::vector<std::uint8_t>(nx * ny, 0)) {}
+
+    // layout[ix + nx * iy] indexes universes, iy = 0 is the bottom row
+    RectLattice(const TwoVec& minCorner, double pitch, int nx, int ny,
+                const std::vector<const Universe*>& universes, const std::vector<std::uint8_t>& layout);
+
+    bool contains(const TwoVec& p) const override {
+        return (p.x >= minCorner.x && p.x <= maxCorner.x) && (p.y >= minCorner.y && p.y <= maxCorner.y);
+    }
+
+    ShapeType shapeType() const override { return LATTICE; }
+    RenderInfo renderInfo() const override {
+        return {LATTICE, maxCorner.x - minCorner.x, maxCorner.y - minCorner.y, centreX, centreY};
+    }
+
+    // nullptr outside the lattice
+    const Material* materialAt(const TwoVec& p) const override;
+    double majorantCrossSec() const override;
+
+private:
+    TwoVec minCorner;
+    TwoVec maxCorner;
+    double pitch;
+    double invPitch;
+    int nx;
+    int ny;
+
+    std::vector<const Universe*> universes;
+    std::vector<std::uint8_t> layout;
+};
+
+// Hexagonal lattice of pointy-top cells with centre to centre distance pitch,
+// rings = 1 is a single cell, every further ring adds the surrounding hexagon of cells.
+// Positions are mapped to axial coordinates and rounded, so lookup is O(1) as well.
+class HexLattice final : public Volume {
+public:
+    HexLattice(const TwoVec& centre, double pitch, int rings, const Universe& universe);
+
+    bool contains(const TwoVec& p) const override {
+        int q{};
+        int r{};
+        cellOf(p, q, r);
+        return hexDistance(q, r) < rings;
+    }
+
+    ShapeType shapeType() const override { return LATTICE; }
+
+    // Renders as the bounding box of the outermost ring
+    RenderInfo renderInfo() const override {
+        return {LATTICE, 2.0 * rings * pitch, 2.0 * rings * pitch, centreX, centreY};
+    }
+
+    // nullptr outside the lattice
+    const Material* materialAt(const TwoVec& p) const override;
+    double majorantCrossSec() const override { return universe->majorantCrossSec(); }
+
+private:
+    void cellOf(const TwoVec& p, int& q, int& r) const;
+
+    static int hexDistance(const int q, const int r) {
+        return (std::abs(q) + std::abs(r) + std::abs(q + r)) / 2;
+    }
+
+    double pitch;
+    int rings;
+    const Universe* universe;
+};
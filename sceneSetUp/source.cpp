@@ -0,0 +1,113 @@
+#include "source.h"
+
+#include <cmath>
+#include <array>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../utils/types.h"
+#include "../utils/mathOps.h"
+#include "volume.h"
+
+
+Source Source::inVolume(const Volume& vol) {
+    Source s;
+    s.shape = VOLUME_SOURCE;
+    s.volume = &vol;
+
+    // Circles report their radius as width/height, every other shape its full extent
+    const auto [type, width, height, x, y] = vol.renderInfo();
+    const double halfX{ type == CIRCLE ? width : width / 2.0 };
+    const double halfY{ type == CIRCLE ? height : height / 2.0 };
+
+    s.a = TwoVec{x - halfX, y - halfY};
+    s.b = TwoVec{x + halfX, y + halfY};
+
+    // Unbounded volumes, e.g. a CSG complement, have no box to sample from
+    if (!std::isfinite(s.a.x) || !std::isfinite(s.a.y) || !std::isfinite(s.b.x) || !std::isfinite(s.b.y))
+        throw std::runtime_error("Volume source needs a volume with finite extents");
+    return s;
+}
+
+
+void Source::samplePositions(TwoVec* positions, const size_t count,
+                             Pcg32& gen, std::uniform_real_distribution<double>& dist) const {
+    const TwoVec span{ b.x - a.x, b.y - a.y };
+
+    switch (shape) {
+        case POINT_SOURCE:
+            std::fill(positions, positions + count, a);
+            break;
+        case LINE_SOURCE:
+            for (size_t i{}; i < count; i++)
+                positions[i] = a + span * dist(gen);
+            break;
+        case AREA_SOURCE:
+            for (size_t i{}; i < count; i++) {
+                const double u{ dist(gen) };
+                positions[i] = a + span * TwoVec{u, dist(gen)};
+            }
+            break;
+        case VOLUME_SOURCE:
+            for (size_t i{}; i < count; i++) {
+                // A volume filling a tiny part of its box, or none of it, would otherwise never return
+                constexpr int maxAttempts{ 1000000 };
+                TwoVec p;
+                int attempts{};
+                do {
+                    if (++attempts > maxAttempts)
+                        throw std::runtime_error("Volume source found no point inside its volume");
+                    const double u{ dist(gen) };
+                    p = a + span * TwoVec{u, dist(gen)};
+                } while (!volume->contains(p));
+                positions[i] = p;
+            }
+            break;
+    }
+}
+
+void Source::sampleDirections(TwoVec* directions, const size_t count,
+                              Pcg32& gen, std::uniform_real_distribution<double>& dist) const {
+    switch (angular) {
+        case MONO_DIRECTIONAL:
+            std::fill(directions, directions + count, axis);
+            break;
+        case CONE:
+            for (size_t i{}; i < count; i++) {
+                const double angle{ halfAngle * (2.0 * dist(gen) - 1.0) };
+                const double c{ std::cos(angle) };
+                const double s{ std::sin(angle) };
+                directions[i] = TwoVec{axis.x * c - axis.y * s, axis.x * s + axis.y * c};
+            }
+            break;
+        case ISOTROPIC:
+            for (size_t i{}; i < count; i++)
+                directions[i] = generate_isotropic_2vec(gen, dist);
+            break;
+    }
+}
+
+void Source::sample(TwoVec* positions, TwoVec* directions, const size_t count,
+                    Pcg32& gen, std::uniform_real_distribution<double>& dist) const {
+    samplePositions(positions, count, gen, dist);
+    sampleDirections(directions, count, gen, dist);
+}
+
+void Source::sampleX(double* positions, double* directionCosines, const size_t count,
+                     Pcg32& gen, std::uniform_real_distribution<double>& dist) const {
+    // Sample through a small stack buffer so the 2D samplers can be reused
+    constexpr size_t chunk{ 256 };
+    std::array<TwoVec, chunk> pos;
+    std::array<TwoVec, chunk> dir;
+
+    for (size_t start{}; start < count; start += chunk) {
+        const size_t n{ std::min(chunk, count - start) };
+        sample(pos.data(), dir.data(), n, gen, dist);
+
+        for (size_t i{}; i < n; i++) {
+            positions[start + i] = pos[i].x;
+            directionCosines[start + i] = dir[i].x;
+        }
+    }
+}
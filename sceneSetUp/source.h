@@ -0,0 +1,98 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "../utils/types.h"
+#include "../utils/random.h"
+#include "volume.h"
+
+// Describes where neutrons are born and in which direction they start travelling.
+// A source is a spatial shape (point, line, area, volume) paired with an angular
+// distribution (mono-directional, cone, isotropic). Both are plain enums so the
+// bulk samplers below switch once per batch instead of once per neutron.
+class Source {
+public:
+    // Default source: a point at the origin emitting along +x
+    Source() : shape(POINT_SOURCE), angular(MONO_DIRECTIONAL), a(0.0, 0.0), b(0.0, 0.0),
+               axis(1.0, 0.0), halfAngle(0.0), volume(nullptr) {}
+
+    static Source point(const TwoVec& p) {
+        Source s;
+        s.a = p;
+        s.b = p;
+        return s;
+    }
+
+    // Uniform along the segment from start to end
+    static Source line(const TwoVec& start, const TwoVec& end) {
+        Source s;
+        s.shape = LINE_SOURCE;
+        s.a = start;
+        s.b = end;
+        return s;
+    }
+
+    // Uniform inside the axis aligned box [minCorner, maxCorner]
+    static Source area(const TwoVec& minCorner, const TwoVec& maxCorner) {
+        Source s;
+        s.shape = AREA_SOURCE;
+        s.a = minCorner;
+        s.b = maxCorner;
+        return s;
+    }
+
+    // Uniform inside an arbitrary volume, rejection sampled from its bounding box.
+    // The volume must outlive the source and have finite extents; sampling throws when
+    // no point inside it is found after a million tries.
+    static Source inVolume(const Volume& vol);
+
+    Source& monoDirectional(const TwoVec& direction) {
+        angular = MONO_DIRECTIONAL;
+        axis = direction * (1.0 / direction.mag());
+        return *this;
+    }
+
+    // Directions uniform in angle within +-halfAngle [rad] of the axis
+    Source& cone(const TwoVec& direction, const double coneHalfAngle) {
+        angular = CONE;
+        axis = direction * (1.0 / direction.mag());
+        halfAngle = coneHalfAngle;
+        return *this;
+    }
+
+    Source& isotropic() {
+        angular = ISOTROPIC;
+        return *this;
+    }
+
+    SourceShape getShape() const { return shape; }
+    AngularDistribution getAngularDistribution() const { return angular; }
+
+    // Fills positions[0, count) and directions[0, count) with freshly born neutrons.
+    // Callers sample straight into their particle arrays, a batch at a time.
+    void sample(TwoVec* positions, TwoVec* directions, size_t count,
+                Pcg32& gen, std::uniform_real_distribution<double>& dist) const;
+
+    // Same as sample() but for the 1D slab engine: x coordinate and x direction cosine only
+    void sampleX(double* positions, double* directionCosines, size_t count,
+                 Pcg32& gen, std::uniform_real_distribution<double>& dist) const;
+
+private:
+    void samplePositions(TwoVec* positions, size_t count,
+                         Pcg32& gen, std::uniform_real_distribution<double>& dist) const;
+    void sampleDirections(TwoVec* directions, size_t count,
+                          Pcg32& gen, std::uniform_real_distribution<double>& dist) const;
+
+    SourceShape shape;
+    AngularDistribution angular;
+
+    // Point: a, Line: a -> b, Area: a = min corner, b = max corner, Volume: bounding box
+    TwoVec a;
+    TwoVec b;
+
+    TwoVec axis;
+    double halfAngle;
+
+    const Volume* volume;
+};
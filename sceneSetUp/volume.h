@@ -2,19 +2,29 @@
 
 #include "../utils/types.h"
 
+class Material;
+
 class Volume {
 public:
-    Volume() : centreX(0.0), centreY(0.0) {}
-    Volume(const double x, const double y) : centreX(x), centreY(y) {}
+    Volume() : centreX(0.0), centreY(0.0), nested(false) {}
+    Volume(const double x, const double y) : centreX(x), centreY(y), nested(false) {}
 
     virtual ~Volume() = default;
     virtual bool contains(const TwoVec& p) const = 0;
     virtual ShapeType shapeType() const = 0;
     virtual RenderInfo renderInfo() const = 0;
 
+    // Nested volumes (lattices) carry their own materials instead of using the one matched by index,
+    // checked through a plain member so ordinary volumes never pay for the virtual calls below.
+    // materialAt() returns nullptr outside the volume, so it doubles as the containment test.
+    bool isNested() const { return nested; }
+    virtual const Material* materialAt(const TwoVec&) const { return nullptr; }
+    virtual double majorantCrossSec() const { return 0.0; }
+
 protected:
     double centreX;
     double centreY;
+    bool nested;
 };
 
 // For now this is just a slab in the x direction
@@ -29,6 +39,9 @@ public:
 
     ShapeType shapeType() const override { return SLAB; }
 
+    double getXMin() const { return xMin; }
+    double getXMax() const { return xMax; }
+
     // For now just huge number in the y direction, not inf though
     RenderInfo renderInfo() const override {
         return {SLAB, xMax - xMin, 999999.9, centreX, centreY};
@@ -50,6 +63,9 @@ public:
     }
     ShapeType shapeType() const override { return CIRCLE; }
 
+    double getRadius() const { return radius; }
+    TwoVec getCentre() const { return {centreX, centreY}; }
+
     RenderInfo renderInfo() const override {
         return {CIRCLE, radius, radius, centreX, centreY};
     }
@@ -73,6 +89,9 @@ public:
         return {RECTANGLE, maxCorner.x - minCorner.x , maxCorner.y - minCorner.y, centreX, centreY};
     }
 
+    TwoVec getMinCorner() const { return minCorner; }
+    TwoVec getMaxCorner() const { return maxCorner; }
+
 private:
     TwoVec minCorner;
     TwoVec maxCorner;
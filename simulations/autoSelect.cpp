@@ -0,0 +1,147 @@
+#include "autoSelect.h"
+
+#include <vector>
+#include <random>
+#include <iostream>
+#include <algorithm>
+
+#include "../utils/material.h"
+#include "../utils/types.h"
+#include "../utils/timer.h"
+#include "../utils/arena.h"
+#include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "../sceneSetUp/boundary.h"
+#include "simulations.h"
+#include "specialized.h"
+#include "batching.h"
+
+
+namespace {
+    struct Candidate {
+        const char* name;
+        BatchJob job;
+    };
+
+    // fastSimulation splits leakage into reflected and transmitted, the 2D engines count all of it
+    // as reflected. All of it goes into reflected, so the totals do not depend on the winner.
+    SimReuslts mergeLeakage(const SimReuslts& r) {
+        return {r.absorbed, r.reflected + r.transmitted, 0};
+    }
+}
+
+AutoSelectResult autoSimulation(const unsigned long numNeutrons, const std::vector<Material>& materials,
+                                const std::vector<const Volume*>& volumes, const Source& source,
+                                const Boundary& boundary, Pcg32& gen, const unsigned long pilotHistories) {
+    if (numNeutrons == 0) return {{0, 0, 0}, "none", {}};
+
+    const bool singleVolume{ volumes.size() == 1 && materials.size() == 1 && !volumes[0]->isNested() };
+    const bool unbounded{ boundary.isUnbounded() };
+
+    std::vector<Candidate> candidates;
+    bool slabEngine{ false };
+
+    // The slab engine is 1D and puts its slab at [0, size], so the scene has to be exactly that
+    if (singleVolume && unbounded && volumes[0]->shapeType() == SLAB &&
+        static_cast<const Slab&>(*volumes[0]).getXMin() == 0.0) {
+        const double slabSize{ static_cast<const Slab&>(*volumes[0]).getXMax() };
+        slabEngine = true;
+        candidates.push_back({"fastSimulation", [&, slabSize](const size_t count, Pcg32& g, RunContext& context) {
+            return fastSimulation<NO_OPT>(count, materials[0], slabSize, source, context, g);
+        }});
+    }
+
+    if (singleVolume) {
+        candidates.push_back({"volumeSimulation", [&](const size_t count, Pcg32& g, RunContext& context) {
+            return volumeSimulation(count, materials[0], *volumes[0], source, boundary, context, g);
+        }});
+    }
+
+    if (unbounded && canSpecialise(materials, volumes)) {
+        candidates.push_back({"specialized woodcock", [&](const size_t count, Pcg32& g, RunContext& context) {
+            return dispatchSimulation(count, materials, volumes, source, context, g);
+        }});
+    }
+
+    candidates.push_back({"woodCockSimulation", [&](const size_t count, Pcg32& g, RunContext& context) {
+        return woodCockSimulation(count, materials, volumes, source, boundary, context, g);
+    }});
+
+    candidates.push_back({"Simulation", [&](const size_t count, Pcg32& g, RunContext&) {
+        Simulation sim(count, materials, volumes, source, static_cast<std::uint32_t>(g()));
+        sim.setBoundary(boundary);
+        while (sim.getCounters().alive > 0) sim.step();
+        return SimReuslts{sim.getCounters().absorbed, sim.getCounters().leaked, 0};
+    }});
+
+    // One context for the pilots and the final run, big enough for the largest engine's buffers.
+    // Faulted in up front so the first pilot is not timed paying for it.
+    RunContext context{ slabEngine ? 5 * (numNeutrons * sizeof(double) + 64) : sourceScratchBytes(numNeutrons) };
+    context.arena().prefault();
+
+    // All pilots together may cost at most a tenth of the job. When that leaves too few histories
+    // to time, selection is skipped and the most specialised candidate runs everything.
+    constexpr unsigned long pilotShare{ 10 };
+    constexpr unsigned long minPilotHistories{ 200 };
+    const unsigned long pilot{ std::min(pilotHistories, numNeutrons / (pilotShare * candidates.size())) };
+    if (candidates.size() == 1 || pilot == 0 || pilot < std::min(minPilotHistories, pilotHistories))
+        return {mergeLeakage(candidates.front().job(numNeutrons, gen, context)), candidates.front().name, {}};
+
+    // An untimed warm up of every candidate first, so no pilot is timed on cold code and caches.
+    // Its histories are thrown away.
+    for (const auto& candidate : candidates) candidate.job(pilot / pilotShare + 1, gen, context);
+
+    // Pilot every candidate on the same number of histories
+    std::vector<EnginePilot> pilots;
+    std::vector<SimReuslts> pilotResults;
+    size_t pooledAbsorbed{};
+    size_t pooledHistories{};
+
+    for (size_t c{}; c < candidates.size(); c++) {
+        Timer t{};
+        const SimReuslts r{ candidates[c].job(pilot, gen, context) };
+        const double seconds{ std::max(t.elapsed() / 1000.0, 1e-9) };
+
+        pilots.push_back({candidates[c].name, pilot, seconds, 0.0});
+        pilotResults.push_back(mergeLeakage(r));
+        pooledAbsorbed += r.absorbed;
+        pooledHistories += pilot;
+    }
+
+    // Every engine is an analog estimator of the same tally, so R^2 per history is the same for
+    // all of them and is estimated from all pilots together. With equal pilots the figure of merit
+    // then only differs by time, and the fastest pilot is chosen directly: separate R^2 estimates
+    // would only add their sampling noise to the choice.
+    const double p{ static_cast<double>(pooledAbsorbed) / static_cast<double>(pooledHistories) };
+    size_t best{};
+    for (size_t e{}; e < pilots.size(); e++) {
+        const double n{ static_cast<double>(pilots[e].histories) };
+        const double relVariance{ (p > 0.0 && p < 1.0) ? (1.0 - p) / (p * n) : 1.0 / n };
+        pilots[e].figureOfMerit = 1.0 / (relVariance * pilots[e].seconds);
+        if (pilots[e].seconds < pilots[best].seconds) best = e;
+    }
+
+    // Only the winner's pilot goes into the totals, so they come from a single engine
+    AutoSelectResult result{ pilotResults[best], pilots[best].name, std::move(pilots) };
+    const Candidate& winner{ candidates[best] };
+    accumulate(result.totals, mergeLeakage(winner.job(numNeutrons - pilot, gen, context)));
+
+    return result;
+}
+
+AutoSelectResult autoSimulation(const unsigned long numNeutrons, const std::vector<Material>& materials,
+                                const std::vector<const Volume*>& volumes, const Source& source,
+                                const Boundary& boundary) {
+    // Random setup
+    std::random_device rd;
+    Pcg32 gen(rd()); // Faster than mt19937
+    return autoSimulation(numNeutrons, materials, volumes, source, boundary, gen);
+}
+
+void printAutoSelectReport(const AutoSelectResult& result) {
+    for (const auto& pilot : result.pilots) {
+        std::cout << "  " << pilot.name << ": " << pilot.histories << " histories in " << 1000.0 * pilot.seconds
+                  << " [ms], FOM " << pilot.figureOfMerit << '\n';
+    }
+    std::cout << "Selected engine: " << result.engine << '\n';
+}
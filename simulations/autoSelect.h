@@ -0,0 +1,42 @@
+// Picking the fastest engine for a scene by timing a short pilot run of each
+#pragma once
+
+#include <vector>
+#include <random>
+
+#include "../utils/material.h"
+#include "../utils/types.h"
+#include "../utils/random.h"
+#include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "../sceneSetUp/boundary.h"
+
+struct EnginePilot {
+    const char* name;
+    unsigned long histories;
+    double seconds;
+    double figureOfMerit;       // 1 / (R^2 T) of the absorbed fraction
+};
+
+struct AutoSelectResult {
+    SimReuslts totals;          // every leaked neutron is in reflected, transmitted is always 0
+    const char* engine;
+    std::vector<EnginePilot> pilots;
+};
+
+// Runs pilotHistories with every engine that can handle the scene: fastSimulation for a single
+// slab starting at x = 0, volumeSimulation for a single volume, the specialised Woodcock engines
+// when the scene matches one, the generic Woodcock engine and the stepped Simulation. The one
+// with the best figure of merit runs the remaining histories, its pilot counts towards the totals.
+// Pilots are shrunk to a tenth of numNeutrons in total; jobs too small for that skip selection
+// and run the first (most specialised) candidate, with no pilots reported.
+// fastSimulation is only tried without optimisations, OPT changes the physics.
+AutoSelectResult autoSimulation(unsigned long numNeutrons, const std::vector<Material>& materials,
+                                const std::vector<const Volume*>& volumes, const Source& source,
+                                const Boundary& boundary, Pcg32& gen, unsigned long pilotHistories = 2000);
+
+AutoSelectResult autoSimulation(unsigned long numNeutrons, const std::vector<Material>& materials,
+                                const std::vector<const Volume*>& volumes, const Source& source = Source{},
+                                const Boundary& boundary = Boundary{});
+
+void printAutoSelectReport(const AutoSelectResult& result);
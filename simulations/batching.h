@@ -0,0 +1,112 @@
+// Splitting a job into batches of histories with reproducible random number streams
+#pragma once
+
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+
+#include "../utils/types.h"
+#include "../utils/random.h"
+#include "../utils/arena.h"
+
+// Runs count histories drawing from gen, one call per batch. context belongs to the thread or
+// process running the batch and is reused for all of its batches.
+using BatchJob = std::function<SimReuslts(size_t count, Pcg32& gen, RunContext& context)>;
+
+// Arena space every worker or rank starts with, grown on demand by batches that need more
+constexpr size_t batchScratchBytes{ size_t{4} << 20 };
+
+struct BatchPlan {
+    size_t numHistories;
+    size_t batchSize;
+
+    size_t numBatches() const { return (numHistories + batchSize - 1) / batchSize; }
+    size_t batchCount(const size_t batch) const { return std::min(batchSize, numHistories - batch * batchSize); }
+};
+
+// Draws between the starts of consecutive batches: the generator's 2^64 period split evenly.
+// With at most 2^32 batches, the most packRange can index, every batch has 2^32 draws to itself.
+inline std::uint64_t batchStride(const size_t numBatches) {
+    return numBatches <= 1 ? ~std::uint64_t{0} : ~std::uint64_t{0} / numBatches;
+}
+
+// Generator for a batch: the seeded stream advanced to the start of that batch's block, so a
+// batch always gets the same numbers no matter which process or thread runs it, which makes
+// every result independent of the split.
+inline Pcg32 batchGenerator(const std::uint32_t seed, const size_t batch, const size_t numBatches) {
+    Pcg32 gen{ seed };
+    gen.advance(batchStride(numBatches) * batch);
+    return gen;
+}
+
+// Runs one batch of plan on its own block of the stream. A batch drawing past the start of the
+// next one would silently correlate the two, so that is an error rather than a result.
+inline SimReuslts runBatch(const BatchJob& job, const BatchPlan& plan, const std::uint32_t seed,
+                           const size_t batch, RunContext& context) {
+    const size_t numBatches{ plan.numBatches() };
+    Pcg32 gen{ batchGenerator(seed, batch, numBatches) };
+    const Pcg32 start{ gen };
+
+    const SimReuslts r{ job(plan.batchCount(batch), gen, context) };
+    if (gen.drawsSince(start) > batchStride(numBatches))
+        throw std::runtime_error("Batch used more random numbers than its stream holds, use fewer batches");
+    return r;
+}
+
+inline void accumulate(SimReuslts& total, const SimReuslts& r) {
+    total.absorbed += r.absorbed;
+    total.reflected += r.reflected;
+    total.transmitted += r.transmitted;
+}
+
+// A contiguous range of batch indices [lo, hi) packed in one word so it can be claimed with a
+// single compare-and-swap: the owner takes batches from the front, thieves from the back.
+inline std::uint64_t packRange(const std::uint32_t lo, const std::uint32_t hi) {
+    return (static_cast<std::uint64_t>(hi) << 32) | lo;
+}
+inline std::uint32_t rangeLo(const std::uint64_t r) { return static_cast<std::uint32_t>(r); }
+inline std::uint32_t rangeHi(const std::uint64_t r) { return static_cast<std::uint32_t>(r >> 32); }
+
+// Static split of numBatches into numParts contiguous ranges, the starting point before any stealing
+inline std::uint64_t initialRange(const size_t part, const size_t numParts, const size_t numBatches) {
+    const size_t lo{ numBatches * part / numParts };
+    const size_t hi{ numBatches * (part + 1) / numParts };
+    return packRange(static_cast<std::uint32_t>(lo), static_cast<std::uint32_t>(hi));
+}
+
+// The claiming protocol shared by the thread scheduler and the distributed runner. Part me takes
+// batches from the front of its own range until it is empty, then steals single batches from the
+// back of the other parts' ranges until all of them are empty. runBatch(batch, stolen) is called
+// for every batch claimed; loadRange and compareExchangeRange give atomic access to the ranges.
+template<typename LoadRange, typename CompareExchangeRange, typename RunBatch>
+void claimBatches(const int me, const int numParts, LoadRange&& loadRange,
+                  CompareExchangeRange&& compareExchangeRange, RunBatch&& runBatch) {
+    // Own share first, from the front
+    while (true) {
+        const std::uint64_t r{ loadRange(me) };
+        if (rangeLo(r) >= rangeHi(r)) break;
+        if (compareExchangeRange(me, r, packRange(rangeLo(r) + 1, rangeHi(r))))
+            runBatch(rangeLo(r), false);
+    }
+
+    // Then one batch at a time from the back of whichever part still has work
+    bool stole{ true };
+    while (stole) {
+        stole = false;
+        for (int k{ 1 }; k < numParts && !stole; k++) {
+            const int victim{ (me + k) % numParts };
+
+            std::uint64_t r{ loadRange(victim) };
+            while (rangeLo(r) < rangeHi(r)) {
+                if (compareExchangeRange(victim, r, packRange(rangeLo(r), rangeHi(r) - 1))) {
+                    runBatch(rangeHi(r) - 1, true);
+                    stole = true;
+                    break;
+                }
+                r = loadRange(victim);
+            }
+        }
+    }
+}
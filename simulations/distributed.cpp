@@ -0,0 +1,235 @@
+#include "distributed.h"
+
+#include <new>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../utils/types.h"
+#include "batching.h"
+
+
+DistributedResult runDistributed(Communicator& comm, const BatchPlan& plan, const std::uint32_t seed, const BatchJob& job) {
+    const size_t numBatches{ plan.numBatches() };
+    const int me{ comm.rank() };
+    const int numRanks{ comm.size() };
+
+    comm.storeRange(me, initialRange(me, numRanks, numBatches));
+    comm.barrier();
+
+    DistributedResult result{{0, 0, 0}, 0, 0};
+    RunContext context{ batchScratchBytes };
+
+    claimBatches(me, numRanks,
+                 [&](const int target) { return comm.loadRange(target); },
+                 [&](const int target, const std::uint64_t expected, const std::uint64_t desired) {
+                     return comm.compareExchangeRange(target, expected, desired);
+                 },
+                 [&](const size_t batch, const bool stolen) {
+                     comm.submit(batch, runBatch(job, plan, seed, batch, context));
+                     result.batchesRun++;
+                     if (stolen) result.batchesStolen++;
+                 });
+
+    // Fixed batch order, so the reduction does not depend on who ran what
+    const std::vector<SimReuslts> all{ comm.gather(numBatches) };
+    for (const auto& r : all)
+        accumulate(result.totals, r);
+
+    return result;
+}
+
+
+LocalProcessCommunicator::LocalProcessCommunicator(const int numProcesses, const size_t numBatches)
+: numProcesses(numProcesses), numBatches(numBatches) {
+    const size_t header{ 64 };
+    mappingSize = header + numProcesses * sizeof(std::atomic<std::uint64_t>) + numBatches * sizeof(SimReuslts);
+
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) throw std::bad_alloc();
+
+    // Lock-free atomics are address free, so they work across processes sharing the mapping
+    auto* bytes = static_cast<std::byte*>(mapping);
+    barrierCount = new (bytes) std::atomic<std::uint32_t>(0);
+    barrierGeneration = new (bytes + sizeof(std::atomic<std::uint32_t>)) std::atomic<std::uint32_t>(0);
+    ranges = reinterpret_cast<std::atomic<std::uint64_t>*>(bytes + header);
+    for (int r{}; r < numProcesses; r++) new (&ranges[r]) std::atomic<std::uint64_t>(0);
+    results = reinterpret_cast<SimReuslts*>(bytes + header + numProcesses * sizeof(std::atomic<std::uint64_t>));
+}
+
+LocalProcessCommunicator::~LocalProcessCommunicator() {
+    munmap(mapping, mappingSize);
+}
+
+std::uint64_t LocalProcessCommunicator::loadRange(const int target) {
+    return ranges[target].load(std::memory_order_acquire);
+}
+
+void LocalProcessCommunicator::storeRange(const int target, const std::uint64_t range) {
+    ranges[target].store(range, std::memory_order_release);
+}
+
+bool LocalProcessCommunicator::compareExchangeRange(const int target, std::uint64_t expected, const std::uint64_t desired) {
+    return ranges[target].compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+}
+
+void LocalProcessCommunicator::submit(const size_t batch, const SimReuslts& result) {
+    results[batch] = result;
+}
+
+std::vector<SimReuslts> LocalProcessCommunicator::gather(const size_t count) {
+    // The barrier orders every submit before the reads below
+    barrier();
+    if (myRank != 0) return {};
+    return std::vector<SimReuslts>(results, results + std::min(count, numBatches));
+}
+
+void LocalProcessCommunicator::barrier() {
+    const std::uint32_t generation{ barrierGeneration->load(std::memory_order_acquire) };
+
+    if (barrierCount->fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<std::uint32_t>(numProcesses)) {
+        barrierCount->store(0, std::memory_order_relaxed);
+        barrierGeneration->fetch_add(1, std::memory_order_acq_rel);
+        return;
+    }
+    while (barrierGeneration->load(std::memory_order_acquire) == generation) {
+        if (myRank == 0) checkChildren();
+        std::this_thread::yield();
+    }
+}
+
+void LocalProcessCommunicator::checkChildren() {
+    // Children only exit after the last barrier has opened, so any exit seen while waiting is a failure
+    for (size_t c{}; c < children.size(); c++) {
+        int status{};
+        if (waitpid(children[c], &status, WNOHANG) != children[c]) continue;
+
+        children.erase(children.begin() + static_cast<std::ptrdiff_t>(c));
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Worker process failed during a distributed run");
+        c--;
+    }
+}
+
+void LocalProcessCommunicator::killChildren() {
+    for (const pid_t child : children) kill(child, SIGKILL);
+    waitChildren();
+}
+
+void LocalProcessCommunicator::waitChildren() {
+    for (const pid_t child : children) waitpid(child, nullptr, 0);
+    children.clear();
+}
+
+
+DistributedResult runLocalMultiProcess(const int numProcesses, const BatchPlan& plan, const std::uint32_t seed, const BatchJob& job) {
+    LocalProcessCommunicator comm(numProcesses, plan.numBatches());
+    const pid_t parent{ getpid() };
+
+    for (int r{ 1 }; r < numProcesses; r++) {
+        const pid_t pid{ fork() };
+        if (pid < 0) {
+            // The others would wait for the missing rank forever
+            comm.killChildren();
+            throw std::runtime_error("Could not fork worker process");
+        }
+        if (pid == 0) {
+            // Never return into the caller's code from here, and do not outlive the parent
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != parent) std::_Exit(1);
+            try {
+                comm.setRank(r);
+                runDistributed(comm, plan, seed, job);
+            }
+            catch (...) {
+                std::_Exit(1);
+            }
+            std::_Exit(0);
+        }
+        comm.addChild(pid);
+    }
+
+    try {
+        const DistributedResult result{ runDistributed(comm, plan, seed, job) };
+        comm.waitChildren();
+        return result;
+    }
+    catch (...) {
+        comm.killChildren();
+        throw;
+    }
+}
+
+
+#ifdef NTS_USE_MPI
+MpiCommunicator::MpiCommunicator(const MPI_Comm comm) : comm(comm) {
+    MPI_Comm_rank(comm, &myRank);
+    MPI_Comm_size(comm, &numRanks);
+
+    MPI_Win_allocate(sizeof(std::uint64_t), sizeof(std::uint64_t), MPI_INFO_NULL, comm, &rangeWord, &window);
+    *rangeWord = 0;
+
+    // Passive target epoch for the whole lifetime, every access below is flushed explicitly
+    MPI_Win_lock_all(0, window);
+}
+
+MpiCommunicator::~MpiCommunicator() {
+    MPI_Win_unlock_all(window);
+    MPI_Win_free(&window);
+}
+
+std::uint64_t MpiCommunicator::loadRange(const int target) {
+    std::uint64_t value{};
+    MPI_Fetch_and_op(nullptr, &value, MPI_UINT64_T, target, 0, MPI_NO_OP, window);
+    MPI_Win_flush(target, window);
+    return value;
+}
+
+void MpiCommunicator::storeRange(const int target, std::uint64_t range) {
+    std::uint64_t previous{};
+    MPI_Fetch_and_op(&range, &previous, MPI_UINT64_T, target, 0, MPI_REPLACE, window);
+    MPI_Win_flush(target, window);
+}
+
+bool MpiCommunicator::compareExchangeRange(const int target, std::uint64_t expected, std::uint64_t desired) {
+    std::uint64_t previous{};
+    MPI_Compare_and_swap(&desired, &expected, &previous, MPI_UINT64_T, target, 0, window);
+    MPI_Win_flush(target, window);
+    return previous == expected;
+}
+
+void MpiCommunicator::submit(const size_t batch, const SimReuslts& result) {
+    finished.insert(finished.end(), {batch, result.absorbed, result.reflected, result.transmitted});
+}
+
+std::vector<SimReuslts> MpiCommunicator::gather(const size_t numBatches) {
+    const int count{ static_cast<int>(finished.size()) };
+    std::vector<int> counts(numRanks);
+    MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+
+    std::vector<int> displacements(numRanks);
+    std::vector<std::uint64_t> all;
+    if (myRank == 0) {
+        for (int r{ 1 }; r < numRanks; r++) displacements[r] = displacements[r - 1] + counts[r - 1];
+        all.resize(displacements[numRanks - 1] + counts[numRanks - 1]);
+    }
+    MPI_Gatherv(finished.data(), count, MPI_UINT64_T, all.data(), counts.data(), displacements.data(),
+                MPI_UINT64_T, 0, comm);
+    finished.clear();
+
+    if (myRank != 0) return {};
+
+    std::vector<SimReuslts> results(numBatches, SimReuslts{0, 0, 0});
+    for (size_t i{}; i + 3 < all.size(); i += 4)
+        results[all[i]] = {all[i + 1], all[i + 2], all[i + 3]};
+    return results;
+}
+#endif
@@ -0,0 +1,137 @@
+// Running a batched job across several processes, over MPI or forked processes on one machine
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "../utils/types.h"
+#include "batching.h"
+
+#ifdef NTS_USE_MPI
+    #include <mpi.h>
+#endif
+
+// What the distributed runner needs from the transport between ranks: one atomically
+// updated work range per rank, somewhere to send finished batches, and a barrier.
+class Communicator {
+public:
+    virtual ~Communicator() = default;
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    // Atomic access to the packed batch range owned by target
+    virtual std::uint64_t loadRange(int target) = 0;
+    virtual void storeRange(int target, std::uint64_t range) = 0;
+    virtual bool compareExchangeRange(int target, std::uint64_t expected, std::uint64_t desired) = 0;
+
+    // Records the result of a finished batch on this rank
+    virtual void submit(size_t batch, const SimReuslts& result) = 0;
+
+    // Collective: on rank 0 returns every batch result indexed by batch, empty elsewhere
+    virtual std::vector<SimReuslts> gather(size_t numBatches) = 0;
+
+    virtual void barrier() = 0;
+};
+
+struct DistributedResult {
+    SimReuslts totals;                  // rank 0 only
+    size_t batchesRun;                  // by this rank
+    size_t batchesStolen;               // by this rank, from other ranks
+};
+
+// Every rank starts on its static share of the batches and, once that is done, steals
+// single batches from the back of the other ranks' ranges until nothing is left. Batch b
+// always uses batchGenerator(seed, b, numBatches) and rank 0 adds the results up in batch
+// order, so the totals are the same for any number of ranks and any steal pattern.
+DistributedResult runDistributed(Communicator& comm, const BatchPlan& plan, std::uint32_t seed, const BatchJob& job);
+
+// Shared memory communicator for processes forked from one parent, mainly for testing the
+// distributed path on a single machine. Must be constructed before forking.
+class LocalProcessCommunicator final : public Communicator {
+public:
+    LocalProcessCommunicator(int numProcesses, size_t numBatches);
+    ~LocalProcessCommunicator() override;
+
+    LocalProcessCommunicator(const LocalProcessCommunicator&) = delete;
+    LocalProcessCommunicator& operator=(const LocalProcessCommunicator&) = delete;
+
+    // Called in each child right after fork
+    void setRank(const int r) { myRank = r; }
+
+    // Rank 0 keeps track of the forked children so its barriers notice one that died, which
+    // would otherwise leave every other rank waiting for it forever
+    void addChild(const pid_t pid) { children.push_back(pid); }
+    void killChildren();
+    void waitChildren();
+
+    int rank() const override { return myRank; }
+    int size() const override { return numProcesses; }
+
+    std::uint64_t loadRange(int target) override;
+    void storeRange(int target, std::uint64_t range) override;
+    bool compareExchangeRange(int target, std::uint64_t expected, std::uint64_t desired) override;
+
+    void submit(size_t batch, const SimReuslts& result) override;
+    std::vector<SimReuslts> gather(size_t numBatches) override;
+    void barrier() override;
+
+private:
+    // Throws if a child exited before the run was over
+    void checkChildren();
+
+    int myRank{ 0 };
+    int numProcesses;
+    size_t numBatches;
+    std::vector<pid_t> children;
+
+    // All of these point into one anonymous MAP_SHARED mapping inherited across fork
+    void* mapping;
+    size_t mappingSize;
+    std::atomic<std::uint32_t>* barrierCount;
+    std::atomic<std::uint32_t>* barrierGeneration;
+    std::atomic<std::uint64_t>* ranges;
+    SimReuslts* results;
+};
+
+// Forks numProcesses - 1 children, runs the job across all of them and returns the totals in the parent.
+// A child whose job throws or crashes makes the parent kill the others and throw instead of hanging.
+DistributedResult runLocalMultiProcess(int numProcesses, const BatchPlan& plan, std::uint32_t seed, const BatchJob& job);
+
+#ifdef NTS_USE_MPI
+// One-sided MPI: each rank exposes its range word in a window so others can steal with
+// MPI_Compare_and_swap while it works. MPI must be initialised before construction.
+// Open MPI 4.1 crashes in its shared memory atomics emulation (osc rdma over btl vader) on
+// a single node, run with --mca osc ^rdma there.
+class MpiCommunicator final : public Communicator {
+public:
+    explicit MpiCommunicator(MPI_Comm comm = MPI_COMM_WORLD);
+    ~MpiCommunicator() override;
+
+    MpiCommunicator(const MpiCommunicator&) = delete;
+    MpiCommunicator& operator=(const MpiCommunicator&) = delete;
+
+    int rank() const override { return myRank; }
+    int size() const override { return numRanks; }
+
+    std::uint64_t loadRange(int target) override;
+    void storeRange(int target, std::uint64_t range) override;
+    bool compareExchangeRange(int target, std::uint64_t expected, std::uint64_t desired) override;
+
+    void submit(size_t batch, const SimReuslts& result) override;
+    std::vector<SimReuslts> gather(size_t numBatches) override;
+    void barrier() override { MPI_Barrier(comm); }
+
+private:
+    MPI_Comm comm;
+    MPI_Win window;
+    std::uint64_t* rangeWord;
+    int myRank;
+    int numRanks;
+
+    // batch, absorbed, reflected, transmitted for every batch finished here
+    std::vector<std::uint64_t> finished;
+};
+#endif
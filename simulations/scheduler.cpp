@@ -0,0 +1,107 @@
+#include "scheduler.h"
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <exception>
+
+#include "../utils/types.h"
+#include "../utils/timer.h"
+#include "../utils/arena.h"
+#include "batching.h"
+
+
+namespace {
+    // One range per cache line so owners claiming from the front do not false-share
+    struct alignas(64) WorkerRange {
+        std::atomic<std::uint64_t> range{ 0 };
+    };
+}
+
+void WorkStealingScheduler::setBatchSize(const size_t size) {
+    if (size == 0) throw std::runtime_error("Batch size must be at least one history");
+    batchSize = size;
+}
+
+ScheduledResult WorkStealingScheduler::run(const size_t numHistories, const std::uint32_t seed, const BatchJob& job) {
+    const BatchPlan plan{ numHistories, batchSize };
+    const size_t numBatches{ plan.numBatches() };
+
+    std::vector<WorkerRange> ranges(numWorkers);
+    for (unsigned w{}; w < numWorkers; w++)
+        ranges[w].range.store(initialRange(w, numWorkers, numBatches), std::memory_order_relaxed);
+
+    std::vector<WorkerStats> stats(numWorkers);
+
+    // First failure of any worker, rethrown on the calling thread once every worker has stopped
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+
+    auto worker = [&](const unsigned me) {
+        using Clock = std::chrono::steady_clock;
+
+        // Kept on this thread's stack while it runs and written back once, so workers updating
+        // their counters after every batch never share a cache line
+        WorkerStats mine{0, 0, 0, {0, 0, 0}, 0.0, 0.0};
+
+        try {
+            // Created and first touched by the thread that first runs this worker
+            if (!contexts[me]) {
+                contexts[me] = std::make_unique<RunContext>(batchScratchBytes);
+                contexts[me]->arena().prefault();
+            }
+            RunContext& context{ *contexts[me] };
+
+            claimBatches(static_cast<int>(me), static_cast<int>(numWorkers),
+                         [&](const int target) { return ranges[target].range.load(std::memory_order_acquire); },
+                         [&](const int target, std::uint64_t expected, const std::uint64_t desired) {
+                             return ranges[target].range.compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+                         },
+                         [&](const size_t batch, const bool stolen) {
+                             const auto start{ Clock::now() };
+                             accumulate(mine.tally, runBatch(job, plan, seed, batch, context));
+                             mine.busySeconds += std::chrono::duration<double>(Clock::now() - start).count();
+                             mine.batchesRun++;
+                             mine.histories += plan.batchCount(batch);
+                             if (stolen) mine.batchesStolen++;
+                         });
+        } catch (...) {
+            {
+                std::lock_guard lock(failureMutex);
+                if (!failure) failure = std::current_exception();
+            }
+            // Empty every range so the other workers stop claiming after their current batch
+            for (auto& r : ranges) r.range.store(packRange(0, 0), std::memory_order_release);
+        }
+
+        stats[me] = mine;
+    };
+
+    Timer t{};
+    std::vector<std::thread> threads;
+    for (unsigned w{ 1 }; w < numWorkers; w++)
+        threads.emplace_back(worker, w);
+    worker(0);
+    for (auto& th : threads) th.join();
+    if (failure) std::rethrow_exception(failure);
+
+    ScheduledResult result{{0, 0, 0}, t.elapsed() / 1000.0, std::move(stats)};
+    for (auto& s : result.workers) {
+        accumulate(result.totals, s.tally);
+        s.utilization = result.wallSeconds > 0.0 ? s.busySeconds / result.wallSeconds : 0.0;
+    }
+    return result;
+}
+
+void printWorkerStats(const ScheduledResult& result) {
+    for (size_t w{}; w < result.workers.size(); w++) {
+        const auto& s{ result.workers[w] };
+        std::cout << "Worker " << w << ": " << s.batchesRun << " batches (" << s.batchesStolen << " stolen), "
+                  << s.histories << " histories, utilization " << 100.0 * s.utilization << "%\n";
+    }
+}
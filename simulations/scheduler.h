@@ -0,0 +1,61 @@
+// Shared memory work stealing over batches of histories
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#include "../utils/types.h"
+#include "../utils/arena.h"
+#include "batching.h"
+
+struct WorkerStats {
+    size_t batchesRun;
+    size_t batchesStolen;
+    size_t histories;
+    SimReuslts tally;       // this worker's share of the totals
+    double busySeconds;     // time spent inside the job
+    double utilization;     // busySeconds over the wall time of the run
+};
+
+struct ScheduledResult {
+    SimReuslts totals;
+    double wallSeconds;
+    std::vector<WorkerStats> workers;
+};
+
+// Runs a batched job on a fixed set of threads. Every worker starts on a contiguous share of
+// the batches and takes them from the front; once it runs dry it steals from the back of the
+// other workers' shares, so long-lived histories (graphite) cannot leave cores idle while the
+// last static chunk finishes. Batches use batchGenerator(), so the totals do not depend on
+// the number of workers or on who ran which batch. Every worker has a RunContext that the job
+// receives, kept across runs and grown from batchScratchBytes when a batch needs more. Each run
+// starts new threads, so a context's pages stay wherever the first run faulted them in.
+// When a job throws, the other workers stop after their current batch and run() rethrows the
+// first exception on the calling thread.
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(const unsigned numWorkers = std::max(1u, std::thread::hardware_concurrency()),
+                                   const size_t batchSize = 256) : numWorkers(numWorkers), contexts(numWorkers) {
+        if (numWorkers == 0) throw std::runtime_error("Scheduler needs at least one worker");
+        setBatchSize(batchSize);
+    }
+
+    // Smaller batches balance better, larger ones cost less in claiming and source sampling
+    void setBatchSize(size_t size);
+    size_t getBatchSize() const { return batchSize; }
+    unsigned getNumWorkers() const { return numWorkers; }
+
+    ScheduledResult run(size_t numHistories, std::uint32_t seed, const BatchJob& job);
+
+private:
+    unsigned numWorkers;
+    size_t batchSize;
+    std::vector<std::unique_ptr<RunContext>> contexts;
+};
+
+void printWorkerStats(const ScheduledResult& result);
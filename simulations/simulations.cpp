@@ -1,5 +1,7 @@
 #include "simulations.h"
 
+#include <span>
+#include <array>
 #include <vector>
 #include <random>
 #include <tuple>
@@ -8,10 +10,27 @@
 #include "../utils/mathOps.h"
 #include "../utils/types.h"
 #include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "../sceneSetUp/boundary.h"
 #include "../utils/logger.h"
+#include "../utils/arena.h"
 
 
-SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat, const Volume& vol) {
+SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat, const Volume& vol, const Source& source,
+                            const Boundary& boundary) {
+    // Random setup
+    std::random_device rd;
+    Pcg32 gen(rd()); // Faster than mt19937
+    return volumeSimulation(numNeutrons, mat, vol, source, boundary, gen);
+}
+
+SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat, const Volume& vol, const Source& source,
+                            const Boundary& boundary, Pcg32& gen) {
+    return volumeSimulation(numNeutrons, mat, vol, source, boundary, threadSourceContext(), gen);
+}
+
+SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat, const Volume& vol, const Source& source,
+                            const Boundary& boundary, RunContext& context, Pcg32& gen) {
     size_t absorbed = 0;
     size_t transmitted = 0;
     size_t reflected = 0;
@@ -19,14 +38,20 @@ SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat
     double randomStep{};
     double randomAbsorp{};
 
-    // Random setup
-    std::random_device rd;
-    std::minstd_rand gen(rd()); // Faster than mt19937
     std::uniform_real_distribution dist(0.0, 1.0);
 
+    const ScatteringLaw* law{ mat.getScatteringLaw() };
+
+    const auto [bornPositions, bornDirections] = sourceBuffers(context, numNeutrons);
+
     for (size_t i{}; i < numNeutrons; i++){
-        TwoVec neutronPosition{0.0, 0.0};
-        TwoVec neutronDirection{1.0, 0.0};
+        const size_t slot{ i % sourceBatchSize };
+        if (slot == 0)
+            source.sample(bornPositions.data(), bornDirections.data(),
+                          std::min<size_t>(sourceBatchSize, numNeutrons - i), gen, dist);
+
+        TwoVec neutronPosition{ bornPositions[slot] };
+        TwoVec neutronDirection{ bornDirections[slot] };
 
         bool isFirstStep{ true };
 
@@ -35,11 +60,11 @@ SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat
             randomAbsorp = dist(gen);
 
             if (isFirstStep) isFirstStep = false;
-            else neutronDirection = generate_isotropic_2vec(gen, dist);
+            else neutronDirection = scatterDirection(law, neutronDirection, gen, dist);
 
             neutronPosition = neutronPosition +  neutronDirection * -std::log(randomStep) * mat.getMeanFreePath();
 
-            if (!vol.contains(neutronPosition)) {
+            if (!boundary.apply(neutronPosition, neutronDirection) || !vol.contains(neutronPosition)) {
                 reflected++;
                 break;
             }
@@ -57,90 +82,93 @@ SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat
 
 
 
-SimReuslts volumeWoodCockSimulation(const unsigned long numNeutrons, const Material& mat1, const Material& mat2, const Volume& vol1, const Volume& vol2) {
+SimReuslts volumeWoodCockSimulation(const unsigned long numNeutrons, const Material& mat1, const Material& mat2, const Volume& vol1, const Volume& vol2,
+                                    const Source& source, const Boundary& boundary) {
+    // Fixed size, so nothing is heap allocated just to describe the scene
+    const std::array<const Volume*, 2> volumes { &vol1, &vol2 };
+    const std::array<Material, 2> materials { mat1, mat2 };
+
+    return woodCockSimulation(numNeutrons, materials, volumes, source, boundary);
+}
+
+SimReuslts woodCockSimulation(const unsigned long numNeutrons, const std::span<const Material> materials, const std::span<const Volume* const> volumes,
+                              const Source& source, const Boundary& boundary) {
+    // Random setup
+    std::random_device rd;
+    Pcg32 gen(rd()); // Faster than mt19937
+    return woodCockSimulation(numNeutrons, materials, volumes, source, boundary, gen);
+}
+
+SimReuslts woodCockSimulation(const unsigned long numNeutrons, const std::span<const Material> materials, const std::span<const Volume* const> volumes,
+                              const Source& source, const Boundary& boundary, Pcg32& gen) {
+    return woodCockSimulation(numNeutrons, materials, volumes, source, boundary, threadSourceContext(), gen);
+}
+
+SimReuslts woodCockSimulation(const unsigned long numNeutrons, const std::span<const Material> materials, const std::span<const Volume* const> volumes,
+                              const Source& source, const Boundary& boundary, RunContext& context, Pcg32& gen) {
     size_t absorbed = 0;
     size_t reflected = 0;
 
-    const std::vector<const Volume*> volumes { &vol1, &vol2 };
-    const std::vector<Material> materials { mat1, mat2 };
-
-    const double majorantCrossSec{ std::max(mat1.getCrossSec(),mat2.getCrossSec()) };
+    const double majorantCrossSec{ findMajorantCrossSec(materials, volumes) };
     const double minMeanFreePath{ 1.0 / majorantCrossSec };
 
-    // Random setup
-    std::random_device rd;
-    std::minstd_rand gen(rd()); // Faster than mt19937
     std::uniform_real_distribution dist(0.0, 1.0);
 
-    for (size_t i{}; i < numNeutrons; i++) {
-        TwoVec neutronPosition{0.0, 0.0};
-        TwoVec neutronDirection{1.0, 0.0};
+    const auto [bornPositions, bornDirections] = sourceBuffers(context, numNeutrons);
 
-        // First step is never fictitious
-        bool isStepFict{ false };
+    for (size_t i{}; i < numNeutrons; i++) {
+        const size_t slot{ i % sourceBatchSize };
+        if (slot == 0)
+            source.sample(bornPositions.data(), bornDirections.data(),
+                          std::min<size_t>(sourceBatchSize, numNeutrons - i), gen, dist);
 
-        // First step performed outside sim.
-        neutronPosition = neutronPosition +  neutronDirection * -std::log( dist(gen) ) * minMeanFreePath;
+        TwoVec neutronPosition{ bornPositions[slot] };
+        TwoVec neutronDirection{ bornDirections[slot] };
 
         DEBUG_LOG("Neutron num: " + std::to_string(i));
 
         while (true) {
-            double currentMeanPath{};
-            double currentAbsProb{};
-
-            double neutronLeft{ true };
-            for (size_t j{}; j < volumes.size(); j++) {
-                if ( volumes[j]->contains(neutronPosition) ) {
-                    neutronLeft = false;
-                    break;
-                }
+            // Tentative flight sampled with the majorant, the same everywhere in the scene
+            const double stepLength{ -minMeanFreePath * std::log(dist(gen)) };
+            neutronPosition = neutronPosition +  neutronDirection * stepLength;
+
+            DEBUG_LOG("\tStep Length" + std::to_string(stepLength));
+
+            if (!boundary.apply(neutronPosition, neutronDirection)) {
+                reflected++;
+                break;
             }
 
-            DEBUG_LOG("\tHas left: " + std::to_string(neutronLeft));
+            const Material* currentMat{ findMaterial(neutronPosition, volumes, materials) };
+
+            DEBUG_LOG("\tHas left: " + std::to_string(currentMat == nullptr));
 
             // exit out of the loop if neutron left the system
-            if (neutronLeft) {
+            if (currentMat == nullptr) {
                 reflected++;
                 break;
             }
 
             // Get the correct material variables
-            for (size_t j{}; j < volumes.size(); j++) {
-                if ( volumes[j]->contains(neutronPosition) ) {
-                    currentMeanPath = materials[j].getMeanFreePath();
-                    currentAbsProb = materials[j].getAbsorptionProb();
-                    break;
-                }
-            }
+            const double currentMeanPath{ currentMat->getMeanFreePath() };
+            const double currentAbsProb{ currentMat->getAbsorptionProb() };
+            const ScatteringLaw* currentLaw{ currentMat->getScatteringLaw() };
 
             DEBUG_LOG("\tCurrent Mean Path: " + std::to_string(currentMeanPath));
             DEBUG_LOG("\tCurrent AbsProb: " + std::to_string(currentAbsProb));
 
-            // only non-fictitious steps can be absorbed
-            if (!isStepFict &&  dist(gen) < currentAbsProb) {
+            // The collision is real with probability crossSec / majorant, otherwise keep flying
+            const double probReal{ 1.0 / (majorantCrossSec * currentMeanPath) };
+            if (dist(gen) > probReal) continue;
 
+            // only real collisions can absorb, in the material where they happen
+            if (dist(gen) < currentAbsProb) {
                 DEBUG_LOG("\tNeutron Absorbed");
                 absorbed++;
                 break;
             }
 
-            const double probFictitious{ 1.0 / (majorantCrossSec * currentMeanPath) };
-
-            //std::cout << "probFictitious: " << probFictitious << '\n';
-
-            if (dist(gen) > probFictitious) {
-                isStepFict = true;
-            }
-            else {
-                // change direction as step is not fictitious
-                isStepFict = false;
-                neutronDirection = generate_isotropic_2vec(gen, dist);
-            }
-
-            const double stepLength{ -minMeanFreePath * std::log(dist(gen)) };
-            neutronPosition = neutronPosition +  neutronDirection * stepLength;
-
-            DEBUG_LOG("\tStep Length" + std::to_string(stepLength));
+            neutronDirection = scatterDirection(currentLaw, neutronDirection, gen, dist);
         }
     }
 
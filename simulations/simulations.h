@@ -1,37 +1,119 @@
 #pragma once
 
+#include <span>
 #include <vector>
 #include <random>
+#include <cstdint>
+#include <utility>
 #include <algorithm>
 
 #include "../utils/material.h"
 #include "../utils/types.h"
+#include "../utils/random.h"
 #include "../utils/mathOps.h"
+#include "../utils/scattering.h"
 #include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "../sceneSetUp/boundary.h"
 #include "../utils/logger.h"
+#include "../utils/arena.h"
+
+// History based engines pull neutrons from the source in batches of this size
+constexpr size_t sourceBatchSize{ 4096 };
+
+SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat, const Volume& vol,
+                            const Source& source = Source{}, const Boundary& boundary = Boundary{});
+SimReuslts volumeWoodCockSimulation(const unsigned long numNeutrons, const Material& mat1, const Material& mat2, const Volume& vol1, const Volume& vol2,
+                                    const Source& source = Source{}, const Boundary& boundary = Boundary{});
+
+// Woodcock engine for any number of volumes, materials[j] fills volumes[j] and the first hit wins
+SimReuslts woodCockSimulation(const unsigned long numNeutrons, std::span<const Material> materials, std::span<const Volume* const> volumes,
+                              const Source& source = Source{}, const Boundary& boundary = Boundary{});
+
+// Same engines drawing from a caller supplied generator, for reproducible and batched runs
+SimReuslts volumeSimulation(unsigned long numNeutrons, const Material& mat, const Volume& vol,
+                            const Source& source, const Boundary& boundary, Pcg32& gen);
+SimReuslts woodCockSimulation(unsigned long numNeutrons, std::span<const Material> materials, std::span<const Volume* const> volumes,
+                              const Source& source, const Boundary& boundary, Pcg32& gen);
+
+// And staging born neutrons in a caller owned context, for drivers running many batches
+SimReuslts volumeSimulation(unsigned long numNeutrons, const Material& mat, const Volume& vol,
+                            const Source& source, const Boundary& boundary, RunContext& context, Pcg32& gen);
+SimReuslts woodCockSimulation(unsigned long numNeutrons, std::span<const Material> materials, std::span<const Volume* const> volumes,
+                              const Source& source, const Boundary& boundary, RunContext& context, Pcg32& gen);
+
+// Arena space for the born neutron buffers of a history engine, which never hold more than one source batch
+inline size_t sourceScratchBytes(const unsigned long numNeutrons) {
+    return 2 * (std::min<size_t>(sourceBatchSize, numNeutrons) * sizeof(TwoVec) + 64);
+}
+
+// Context behind the overloads that are not given one, shared by all such calls on a thread
+inline RunContext& threadSourceContext() {
+    thread_local RunContext context{ sourceScratchBytes(sourceBatchSize) };
+    return context;
+}
 
-SimReuslts volumeSimulation(const unsigned long numNeutrons, const Material& mat, const Volume& vol);
-SimReuslts volumeWoodCockSimulation(const unsigned long numNeutrons, const Material& mat1, const Material& mat2, const Volume& vol1, const Volume& vol2);
+// Carves the born neutron buffers for a run of numNeutrons from the context
+inline std::pair<std::span<TwoVec>, std::span<TwoVec>> sourceBuffers(RunContext& context, const unsigned long numNeutrons) {
+    context.beginRun();
+    const size_t count{ std::min<size_t>(sourceBatchSize, numNeutrons) };
+    const std::span<TwoVec> positions{ context.arena().allocate<TwoVec>(count) };
+    return { positions, context.arena().allocate<TwoVec>(count) };
+}
+
+// Material at p, or nullptr once p has left every volume. The first volume containing p wins,
+// nested volumes (lattices) resolve their own material and only need a placeholder in materials.
+// A nested volume's materialAt() also tells whether p is inside, so its cell is only found once.
+inline const Material* findMaterial(const TwoVec& p, const std::span<const Volume* const> volumes,
+                                    const std::span<const Material> materials) {
+    for (size_t j{}; j < volumes.size(); j++) {
+        if (volumes[j]->isNested()) {
+            if (const Material* m{ volumes[j]->materialAt(p) }) return m;
+        }
+        else if (volumes[j]->contains(p)) return &materials[j];
+    }
+    return nullptr;
+}
+
+// Largest cross section anywhere in the scene, including inside nested volumes. The material
+// paired with a nested volume is only a placeholder, it never fills any space, so it is skipped.
+inline double findMajorantCrossSec(const std::span<const Material> materials, const std::span<const Volume* const> volumes) {
+    double majorant{ -1 };
+    for (size_t j{}; j < std::max(materials.size(), volumes.size()); j++) {
+        if (j < volumes.size() && volumes[j]->isNested()) majorant = std::max(majorant, volumes[j]->majorantCrossSec());
+        else if (j < materials.size()) majorant = std::max(majorant, materials[j].getCrossSec());
+    }
+    return majorant;
+}
 
 void stepVolumeWoodCockSimulation(std::vector<TwoVec>& neutronPositions, std::vector<bool>& isStepFict, std::vector<bool>& alive,const std::vector<Material>& materials, const std::vector<const Volume*> &volumes);
+
+// Each call is one run: the context is reset and the particle and scratch buffers are carved
+// from its arena, so back to back runs reuse the same already faulted-in memory.
 template<EnableOptimizations opt>
-SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat, const double slabSize) {
+SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat, const double slabSize,
+                          const Source& source, RunContext& context, Pcg32& gen) {
     size_t absorbed = 0;
     size_t transmitted = 0;
     size_t reflected = 0;
 
     // Pre-allocate contiguous memory
-    std::vector positions(numNeutrons, 0.0);
-    std::vector directions(numNeutrons, 1.0);
-    std::vector<double> random_step(numNeutrons);
-    std::vector<double> random_abs(numNeutrons);
-    std::vector<double> random_dir(numNeutrons);
+    context.beginRun();
+    Arena& arena{ context.arena() };
+    const std::span<double> positions{ arena.allocate<double>(numNeutrons) };
+    const std::span<double> directions{ arena.allocate<double>(numNeutrons) };
+    const std::span<double> random_step{ arena.allocate<double>(numNeutrons) };
+    const std::span<double> random_abs{ arena.allocate<double>(numNeutrons) };
+    const std::span<double> random_dir{ arena.allocate<double>(numNeutrons) };
 
-    // Random setup
-    std::random_device rd;
-    std::minstd_rand gen(rd()); // Faster than mt19937
     std::uniform_real_distribution dist(0.0, 1.0);
 
+    // Only the x components matter in the slab
+    source.sampleX(positions.data(), directions.data(), numNeutrons, gen, dist);
+
+    // Anisotropic laws depend on the incoming direction, so they are sampled during compaction instead
+    const ScatteringLaw* law{ mat.getScatteringLaw() };
+
     size_t activeCount = numNeutrons;
 
     while (activeCount > 0) {
@@ -39,6 +121,7 @@ SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat,
         for (size_t i = 0; i < activeCount; ++i) {
             random_step[i] = dist(gen);
             random_abs[i] = dist(gen);
+            if (law != nullptr) continue;
             if (opt == OPT) random_dir[i] = 2 * dist(gen) - 1;
             else random_dir[i] = generate_isotropic_xcoord(gen, dist);
         }
@@ -63,7 +146,7 @@ SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat,
             } else {
                 // Keep neutron for next step
                 positions[newActiveCount] = pos;
-                directions[newActiveCount] = random_dir[i];
+                directions[newActiveCount] = law ? law->scatterCosine(directions[i], gen, dist) : random_dir[i];
                 ++newActiveCount;
             }
         }
@@ -74,32 +157,53 @@ SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat,
     return {absorbed, reflected, transmitted};
 }
 
+template<EnableOptimizations opt>
+SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat, const double slabSize,
+                          const Source& source, RunContext& context) {
+    // Random setup
+    std::random_device rd;
+    Pcg32 gen(rd()); // Faster than mt19937
+    return fastSimulation<opt>(numNeutrons, mat, slabSize, source, context, gen);
+}
+
+// One-off run with its own memory
+template<EnableOptimizations opt>
+SimReuslts fastSimulation(const unsigned long numNeutrons, const Material& mat, const double slabSize,
+                          const Source& source = Source{}) {
+    RunContext context{ 5 * (numNeutrons * sizeof(double) + 64) };
+    return fastSimulation<opt>(numNeutrons, mat, slabSize, source, context);
+}
+
 
 class Simulation {
 public:
-    // Intializing simulation with all alive neutrons which their first step will not be fictitious
+    // Default source: neutrons facing x axis, jittered by 1e-6 around the origin
+    static Source defaultSource() { return Source::area(TwoVec{-1e-6, -1e-6}, TwoVec{1e-6, 1e-6}); }
+
+    // Intializing simulation with all alive neutrons at their birth positions.
+    // Pass a seed for a reproducible run, by default every simulation gets a fresh one.
     Simulation(const size_t numNeutrons, const std::vector<Material>& materials,
-               const std::vector<const Volume*>& volumes) : m_materials(materials), m_volumes(volumes),
-                                                            m_numNeutrons(numNeutrons), m_numAbsorbed(0),
-                                                            m_alive(numNeutrons, 1),
-                                                            m_isStepFict(numNeutrons, 0),
-                                                            m_neutronPositions(numNeutrons, TwoVec{0.0, 0.0}),
-                                                            m_neutronDirections(numNeutrons, TwoVec{1.0, 0.0}) {
-        // neutrons facing x axis by default
-
-        m_majorantCrossSec = -1;
-        for (size_t i{}; i < m_materials.size(); i++)
-            m_majorantCrossSec = std::max(m_majorantCrossSec, m_materials[i].getCrossSec());
+               const std::vector<const Volume*>& volumes,
+               const Source& source = defaultSource(),
+               const std::uint32_t seed = std::random_device{}()) : m_materials(materials), m_volumes(volumes),
+                                                         m_numNeutrons(numNeutrons), m_numAbsorbed(0),
+                                                         m_counters{numNeutrons, 0, 0, 0, 0},
+                                                         m_alive(numNeutrons, 1),
+                                                         m_neutronPositions(numNeutrons),
+                                                         m_neutronDirections(numNeutrons),
+                                                         m_gen(seed) {
+        m_majorantCrossSec = findMajorantCrossSec(m_materials, m_volumes);
 
         m_minMeanFreePath = 1.0 / m_majorantCrossSec;
-        std::uniform_real_distribution<double> jitter(-1e-6, 1e-6);
-        for (auto &pos: m_neutronPositions) {
-            pos.x += jitter(m_gen);
-            pos.y += jitter(m_gen);
-        }
+
+        source.sample(m_neutronPositions.data(), m_neutronDirections.data(), m_numNeutrons, m_gen, m_dist);
     }
 
     size_t getNumAbsorbed() const { return m_numAbsorbed; }
+    const SimCounters& getCounters() const { return m_counters; }
+
+    // Outer domain applied before the volume lookup, by default there is none
+    void setBoundary(const Boundary& boundary) { m_boundary = boundary; }
 
     // randomizes the neutron directions as in some experiments they might originate conically or isotropically
     void isotropicNeutronDirections() {
@@ -110,98 +214,99 @@ public:
 
     // does one step in the simulation
     void step() {
+        m_counters.steps++;
         for (size_t i{}; i < m_numNeutrons; i++) {
             if (!m_alive[i]) continue;
 
             DEBUG_LOG("Neutron num: " + std::to_string(i));
 
-            double currentMeanPath{};
-            double currentAbsProb{};
+            const double stepLength{ -m_minMeanFreePath * std::log(m_dist(m_gen)) };
+            m_neutronPositions[i] = m_neutronPositions[i] + m_neutronDirections[i] * stepLength;
+
+            DEBUG_LOG("\tStep Length" + std::to_string(stepLength));
 
-            double neutronLeft{ true };
-            for (size_t j{}; j < m_volumes.size(); j++) {
-                if ( m_volumes[j]->contains(m_neutronPositions[i]) ) {
-                    neutronLeft = false;
-                    break;
-                }
+            if (!m_boundary.apply(m_neutronPositions[i], m_neutronDirections[i])) {
+                m_alive[i] = false;
+                m_counters.alive--;
+                m_counters.leaked++;
+                continue;
             }
 
-            DEBUG_LOG("\tHas left: " + std::to_string(neutronLeft));
+            const Material* currentMat{ findMaterial(m_neutronPositions[i], m_volumes, m_materials) };
+
+            DEBUG_LOG("\tHas left: " + std::to_string(currentMat == nullptr));
 
             // exit out of the loop if neutron left the system
-            if (neutronLeft) {
+            if (currentMat == nullptr) {
                 m_alive[i] = false;
+                m_counters.alive--;
+                m_counters.leaked++;
                 continue;
                 // You can kill the neutron or just let it travel
                 //currentMeanPath = 999999;
                 //currentAbsProb = 0.000000;
             }
-            else {
-                // Get the correct material variables
-                for (size_t j{}; j < m_volumes.size(); j++) {
-                    if ( m_volumes[j]->contains(m_neutronPositions[i]) ) {
-                        currentMeanPath = m_materials[j].getMeanFreePath();
-                        currentAbsProb = m_materials[j].getAbsorptionProb();
-                        break;
-                    }
-                }
-            }
 
+            // Get the correct material variables
+            const double currentMeanPath{ currentMat->getMeanFreePath() };
+            const double currentAbsProb{ currentMat->getAbsorptionProb() };
+            const ScatteringLaw* currentLaw{ currentMat->getScatteringLaw() };
 
             DEBUG_LOG("\tCurrent Mean Path: " + std::to_string(currentMeanPath));
             DEBUG_LOG("\tCurrent AbsProb: " + std::to_string(currentAbsProb));
 
-            // only non-fictitious steps can be absorbed
-            if (!m_isStepFict[i] &&  m_dist(m_gen) < currentAbsProb) {
+            // The collision is real with probability crossSec / majorant, otherwise keep flying
+            const double probReal{ 1.0 / (m_majorantCrossSec * currentMeanPath) };
+
+            DEBUG_LOG("\tprobReal: " + std::to_string(probReal));
+            if (m_dist(m_gen) > probReal) continue;
+
+            m_counters.collisions++;
+
+            // only real collisions can absorb
+            if (m_dist(m_gen) < currentAbsProb) {
                 DEBUG_LOG("\tNeutron Absorbed");
                 m_alive[i] = false;
                 m_numAbsorbed++;
+                m_counters.alive--;
+                m_counters.absorbed++;
                 continue;
             }
 
-            const double probFictitious{ 1.0 / (m_majorantCrossSec * currentMeanPath) };
-
-            DEBUG_LOG("\tprobFictitious: " + std::to_string(probFictitious));
-            if (m_dist(m_gen) > probFictitious) {
-                m_isStepFict[i] = true;
-            }
-            else {
-                // change direction as step is not fictitious
-                m_isStepFict[i] = false;
-                m_neutronDirections[i] = generate_isotropic_2vec(m_gen, m_dist);
-            }
-
-            const double stepLength{ -m_minMeanFreePath * std::log(m_dist(m_gen)) };
-            m_neutronPositions[i] = m_neutronPositions[i] + m_neutronDirections[i] * stepLength;
-
-            DEBUG_LOG("\tStep Length" + std::to_string(stepLength));
+            m_neutronDirections[i] = scatterDirection(currentLaw, m_neutronDirections[i], m_gen, m_dist);
         }
     }
 
     void printSimStats() const {
-        const size_t aliveCount = std::ranges::count(m_alive, true);
-        std::cout << "Number of Neutrons Alive: " << aliveCount << '/' << m_numNeutrons << '\n';
+        std::cout << "Number of Neutrons Alive: " << m_counters.alive << '/' << m_numNeutrons << '\n';
     }
 
     std::vector<TwoVec> getNeutronPositions() const { return m_neutronPositions; }
     std::vector<char> getAliveNeutrons() const { return m_alive; }
 
+    // Copies the particle state into caller owned buffers, reusing their capacity
+    void copyState(std::vector<TwoVec>& positions, std::vector<char>& alive) const {
+        positions.assign(m_neutronPositions.begin(), m_neutronPositions.end());
+        alive.assign(m_alive.begin(), m_alive.end());
+    }
+
 private:
     // Using char instead of bool because of how std::vector handles bools with proxy objects
     std::vector<Material> m_materials;
     std::vector<const Volume*> m_volumes;
+    Boundary m_boundary;
     size_t m_numNeutrons;
     size_t m_numAbsorbed;
+    SimCounters m_counters;
 
     std::vector<char> m_alive;
-    std::vector<char> m_isStepFict;
     std::vector<TwoVec> m_neutronPositions;
     std::vector<TwoVec> m_neutronDirections;
 
     double m_majorantCrossSec;
     double m_minMeanFreePath;
 
-    std::minstd_rand m_gen{std::random_device{}()};
+    Pcg32 m_gen;
     std::uniform_real_distribution<double> m_dist{0.0, 1.0};
 };
 
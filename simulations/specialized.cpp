@@ -0,0 +1,85 @@
+#include "specialized.h"
+
+#include <vector>
+#include <random>
+
+#include "../utils/material.h"
+#include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "simulations.h"
+
+
+SimReuslts dispatchSimulation(const unsigned long numNeutrons, const std::vector<Material>& materials,
+                              const std::vector<const Volume*>& volumes, const Source& source,
+                              const char** engineName) {
+    std::random_device rd;
+    Pcg32 gen(rd());
+    return dispatchSimulation(numNeutrons, materials, volumes, source, threadSourceContext(), gen, engineName);
+}
+
+const char* Specialisation::name() const {
+    switch (kind) {
+        case SINGLE_SLAB_SPECIALISATION: return "single slab";
+        case SINGLE_CIRCLE_SPECIALISATION: return "single circle";
+        case SINGLE_RECTANGLE_SPECIALISATION: return "single rectangle";
+        case TWO_SLAB_STACK_SPECIALISATION: return "two slab stack";
+        default: return "generic woodcock";
+    }
+}
+
+Specialisation findSpecialisation(const std::vector<Material>& materials, const std::vector<const Volume*>& volumes) {
+    if (volumes.size() != materials.size()) return {NO_SPECIALISATION, 0, 0};
+    for (size_t j{}; j < volumes.size(); j++)
+        if (volumes[j]->isNested() || materials[j].getScatteringLaw() != nullptr) return {NO_SPECIALISATION, 0, 0};
+
+    if (volumes.size() == 1 && volumes[0]->shapeType() == SLAB) return {SINGLE_SLAB_SPECIALISATION, 0, 0};
+    if (volumes.size() == 1 && volumes[0]->shapeType() == CIRCLE) return {SINGLE_CIRCLE_SPECIALISATION, 0, 0};
+    if (volumes.size() == 1 && volumes[0]->shapeType() == RECTANGLE) return {SINGLE_RECTANGLE_SPECIALISATION, 0, 0};
+
+    // Two slabs sharing a face, in either order
+    if (volumes.size() == 2 && volumes[0]->shapeType() == SLAB && volumes[1]->shapeType() == SLAB) {
+        const auto& a{ static_cast<const Slab&>(*volumes[0]) };
+        const auto& b{ static_cast<const Slab&>(*volumes[1]) };
+        if (a.getXMax() == b.getXMin()) return {TWO_SLAB_STACK_SPECIALISATION, 0, 1};
+        if (b.getXMax() == a.getXMin()) return {TWO_SLAB_STACK_SPECIALISATION, 1, 0};
+    }
+
+    return {NO_SPECIALISATION, 0, 0};
+}
+
+SimReuslts dispatchSimulation(const unsigned long numNeutrons, const std::vector<Material>& materials,
+                              const std::vector<const Volume*>& volumes, const Source& source,
+                              RunContext& context, Pcg32& gen, const char** engineName) {
+    const Specialisation spec{ findSpecialisation(materials, volumes) };
+    if (engineName) *engineName = spec.name();
+
+    switch (spec.kind) {
+        case SINGLE_SLAB_SPECIALISATION: {
+            const auto& slab{ static_cast<const Slab&>(*volumes[0]) };
+            return specializedWoodCockSimulation(numNeutrons, SingleSlabGeometry{slab.getXMin(), slab.getXMax()},
+                                                 RegionMaterials<1>({MaterialConstants(materials[0])}), source, context, gen);
+        }
+        case SINGLE_CIRCLE_SPECIALISATION: {
+            const auto& circle{ static_cast<const Circle&>(*volumes[0]) };
+            const TwoVec centre{ circle.getCentre() };
+            return specializedWoodCockSimulation(numNeutrons, CircleGeometry{circle.getRadius() * circle.getRadius(), centre.x, centre.y},
+                                                 RegionMaterials<1>({MaterialConstants(materials[0])}), source, context, gen);
+        }
+        case SINGLE_RECTANGLE_SPECIALISATION: {
+            const auto& rect{ static_cast<const Rectanle&>(*volumes[0]) };
+            const TwoVec lo{ rect.getMinCorner() };
+            const TwoVec hi{ rect.getMaxCorner() };
+            return specializedWoodCockSimulation(numNeutrons, RectangleGeometry{lo.x, hi.x, lo.y, hi.y},
+                                                 RegionMaterials<1>({MaterialConstants(materials[0])}), source, context, gen);
+        }
+        case TWO_SLAB_STACK_SPECIALISATION: {
+            const auto& lower{ static_cast<const Slab&>(*volumes[spec.lower]) };
+            const auto& upper{ static_cast<const Slab&>(*volumes[spec.upper]) };
+            return specializedWoodCockSimulation(numNeutrons, TwoSlabStackGeometry{lower.getXMin(), lower.getXMax(), upper.getXMax()},
+                                                 RegionMaterials<2>({MaterialConstants(materials[spec.lower]), MaterialConstants(materials[spec.upper])}),
+                                                 source, context, gen);
+        }
+        default:
+            return woodCockSimulation(numNeutrons, materials, volumes, source, Boundary{}, context, gen);
+    }
+}
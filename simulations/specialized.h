@@ -0,0 +1,212 @@
+// Woodcock engines specialised at compile time for common geometry / material combinations
+#pragma once
+
+#include <array>
+#include <vector>
+#include <random>
+
+#include "../utils/material.h"
+#include "../utils/types.h"
+#include "../utils/random.h"
+#include "../utils/mathOps.h"
+#include "../utils/arena.h"
+#include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "simulations.h"
+
+// Only the numbers the transport loop needs, as a literal type so it can be constexpr
+struct MaterialConstants {
+    double crossSection;
+    double absorptionProbability;
+
+    constexpr MaterialConstants(const double crossSec, const double absProb) : crossSection(crossSec), absorptionProbability(absProb) {}
+    explicit MaterialConstants(const Material& mat) : MaterialConstants(mat.getCrossSec(), mat.getAbsorptionProb()) {}
+};
+
+// Per region constants with everything derivable precomputed: the majorant mean free path
+// and the probability that a tentative collision in a region is real.
+template<int N>
+struct RegionMaterials {
+    std::array<double, N> absorptionProb{};
+    std::array<double, N> realCollisionProb{};
+    double majorantMeanFreePath{};
+
+    constexpr explicit RegionMaterials(const std::array<MaterialConstants, N>& mats) {
+        double majorant{};
+        for (int r{}; r < N; r++) majorant = mats[r].crossSection > majorant ? mats[r].crossSection : majorant;
+
+        majorantMeanFreePath = 1.0 / majorant;
+        for (int r{}; r < N; r++) {
+            absorptionProb[r] = mats[r].absorptionProbability;
+            realCollisionProb[r] = mats[r].crossSection / majorant;
+        }
+    }
+};
+
+// Geometry policies: regionOf() returns the region index, or -1 once the neutron has left.
+// All inline and non-virtual so the kernel sees straight-line comparisons.
+struct SingleSlabGeometry {
+    static constexpr int numRegions{ 1 };
+    double xMin;
+    double xMax;
+
+    constexpr int regionOf(const TwoVec& p) const { return (p.x >= xMin && p.x <= xMax) ? 0 : -1; }
+};
+
+struct CircleGeometry {
+    static constexpr int numRegions{ 1 };
+    double radius2;
+    double x;
+    double y;
+
+    constexpr int regionOf(const TwoVec& p) const {
+        const double dx{ p.x - x };
+        const double dy{ p.y - y };
+        return (dx * dx + dy * dy <= radius2) ? 0 : -1;
+    }
+};
+
+struct RectangleGeometry {
+    static constexpr int numRegions{ 1 };
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+
+    constexpr int regionOf(const TwoVec& p) const {
+        return (p.x >= xMin && p.x <= xMax && p.y >= yMin && p.y <= yMax) ? 0 : -1;
+    }
+};
+
+// Two slabs side by side: [x0, x1] is region 0 and (x1, x2] region 1
+struct TwoSlabStackGeometry {
+    static constexpr int numRegions{ 2 };
+    double x0;
+    double x1;
+    double x2;
+
+    constexpr int regionOf(const TwoVec& p) const {
+        if (p.x < x0 || p.x > x2) return -1;
+        return p.x <= x1 ? 0 : 1;
+    }
+};
+
+// What the kernel transports through. RuntimeProblem refers to constants built at run time,
+// FixedProblem holds them as static constexpr members, so they are part of its type and every
+// kernel instantiation for it sees literals whether or not anything gets inlined.
+template<typename Geometry>
+struct RuntimeProblem {
+    static constexpr int numRegions{ Geometry::numRegions };
+    const Geometry& geometry;
+    const RegionMaterials<numRegions>& mats;
+};
+
+template<auto fixedGeometry, RegionMaterials<decltype(fixedGeometry)::numRegions> fixedMats>
+struct FixedProblem {
+    static constexpr int numRegions{ decltype(fixedGeometry)::numRegions };
+    static constexpr auto geometry{ fixedGeometry };
+    static constexpr RegionMaterials<numRegions> mats{ fixedMats };
+};
+
+// Same physics as woodCockSimulation with isotropic scattering and no outer boundary.
+// A single region needs no fictitious collisions at all, so that test compiles away.
+template<typename Problem>
+SimReuslts specializedWoodCockKernel(const unsigned long numNeutrons, const Problem& problem,
+                                     const Source& source, RunContext& context, Pcg32& gen) {
+    size_t absorbed = 0;
+    size_t reflected = 0;
+
+    std::uniform_real_distribution dist(0.0, 1.0);
+    const double minMeanFreePath{ problem.mats.majorantMeanFreePath };
+
+    const auto [bornPositions, bornDirections] = sourceBuffers(context, numNeutrons);
+
+    for (size_t i{}; i < numNeutrons; i++) {
+        const size_t slot{ i % sourceBatchSize };
+        if (slot == 0)
+            source.sample(bornPositions.data(), bornDirections.data(),
+                          std::min<size_t>(sourceBatchSize, numNeutrons - i), gen, dist);
+
+        TwoVec neutronPosition{ bornPositions[slot] };
+        TwoVec neutronDirection{ bornDirections[slot] };
+
+        while (true) {
+            neutronPosition = neutronPosition + neutronDirection * -std::log( dist(gen) ) * minMeanFreePath;
+
+            const int region{ problem.geometry.regionOf(neutronPosition) };
+            if (region < 0) {
+                reflected++;
+                break;
+            }
+
+            if constexpr (Problem::numRegions > 1) {
+                if (dist(gen) > problem.mats.realCollisionProb[region]) continue;
+            }
+
+            if (dist(gen) < problem.mats.absorptionProb[region]) {
+                absorbed++;
+                break;
+            }
+
+            neutronDirection = generate_isotropic_2vec(gen, dist);
+        }
+    }
+
+    return {absorbed, reflected, 0};
+}
+
+template<typename Geometry>
+SimReuslts specializedWoodCockSimulation(const unsigned long numNeutrons, const Geometry& geometry,
+                                         const RegionMaterials<Geometry::numRegions>& mats,
+                                         const Source& source, RunContext& context, Pcg32& gen) {
+    return specializedWoodCockKernel(numNeutrons, RuntimeProblem<Geometry>{geometry, mats}, source, context, gen);
+}
+
+template<typename Geometry>
+SimReuslts specializedWoodCockSimulation(const unsigned long numNeutrons, const Geometry& geometry,
+                                         const RegionMaterials<Geometry::numRegions>& mats,
+                                         const Source& source, Pcg32& gen) {
+    return specializedWoodCockSimulation(numNeutrons, geometry, mats, source, threadSourceContext(), gen);
+}
+
+// Problems fixed at compile time, e.g. specializedWoodCockSimulation<SingleSlabGeometry{0.0, 10.0}, waterConstants>(n, ...),
+// instantiate the kernel on a FixedProblem, so the constants are part of its type
+template<auto geometry, RegionMaterials<decltype(geometry)::numRegions> mats>
+SimReuslts specializedWoodCockSimulation(const unsigned long numNeutrons, const Source& source, Pcg32& gen) {
+    return specializedWoodCockKernel(numNeutrons, FixedProblem<geometry, mats>{}, source, threadSourceContext(), gen);
+}
+
+enum SpecialisationKind {
+    NO_SPECIALISATION=0,
+    SINGLE_SLAB_SPECIALISATION=1,
+    SINGLE_CIRCLE_SPECIALISATION=2,
+    TWO_SLAB_STACK_SPECIALISATION=3,
+    SINGLE_RECTANGLE_SPECIALISATION=4,
+};
+
+// The specialised instantiation a scene matches. For a two slab stack, lower and upper are
+// the indices of the slabs at smaller and larger x, otherwise lower is the only volume.
+struct Specialisation {
+    SpecialisationKind kind;
+    size_t lower;
+    size_t upper;
+
+    const char* name() const;
+};
+
+// Matches the scene against the specialised geometries without running anything
+Specialisation findSpecialisation(const std::vector<Material>& materials, const std::vector<const Volume*>& volumes);
+
+inline bool canSpecialise(const std::vector<Material>& materials, const std::vector<const Volume*>& volumes) {
+    return findSpecialisation(materials, volumes).kind != NO_SPECIALISATION;
+}
+
+// Picks a specialised instantiation when the scene matches one (single slab, circle or rectangle,
+// two adjacent slabs, isotropic scattering) and falls back to woodCockSimulation otherwise.
+// The name of the engine used is written to engineName when given.
+SimReuslts dispatchSimulation(unsigned long numNeutrons, const std::vector<Material>& materials,
+                              const std::vector<const Volume*>& volumes, const Source& source = Source{},
+                              const char** engineName = nullptr);
+SimReuslts dispatchSimulation(unsigned long numNeutrons, const std::vector<Material>& materials,
+                              const std::vector<const Volume*>& volumes, const Source& source,
+                              RunContext& context, Pcg32& gen, const char** engineName = nullptr);
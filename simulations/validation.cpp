@@ -0,0 +1,575 @@
+#include "validation.h"
+
+#include <span>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <limits>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "../utils/material.h"
+#include "../utils/mathOps.h"
+#include "../utils/types.h"
+#include "../utils/arena.h"
+#include "../utils/scattering.h"
+#include "../sceneSetUp/volume.h"
+#include "../sceneSetUp/source.h"
+#include "../sceneSetUp/boundary.h"
+#include "../sceneSetUp/csg.h"
+#include "../sceneSetUp/lattice.h"
+#include "simulations.h"
+#include "specialized.h"
+#include "scheduler.h"
+#include "distributed.h"
+#include "batching.h"
+
+
+double binomialZScore(const size_t successes, const size_t trials, const double p) {
+    const double n{ static_cast<double>(trials) };
+    const double variance{ n * p * (1.0 - p) };
+    if (variance <= 0.0) return static_cast<double>(successes) == n * p ? 0.0 : std::numeric_limits<double>::infinity();
+    return (static_cast<double>(successes) - n * p) / std::sqrt(variance);
+}
+
+double chiSquareHomogeneity(const std::span<const size_t> a, const std::span<const size_t> b, int& dof) {
+    double totalA{};
+    double totalB{};
+    for (size_t c{}; c < a.size(); c++) {
+        totalA += static_cast<double>(a[c]);
+        totalB += static_cast<double>(b[c]);
+    }
+    const double total{ totalA + totalB };
+
+    double chi2{};
+    dof = -1;
+    for (size_t c{}; c < a.size(); c++) {
+        const double column{ static_cast<double>(a[c] + b[c]) };
+        if (column == 0.0) continue;
+        dof++;
+
+        const double expectedA{ column * totalA / total };
+        const double expectedB{ column * totalB / total };
+        chi2 += (a[c] - expectedA) * (a[c] - expectedA) / expectedA;
+        chi2 += (b[c] - expectedB) * (b[c] - expectedB) / expectedB;
+    }
+    return chi2;
+}
+
+double normalPValue(const double z) {
+    return std::erfc(std::abs(z) / std::sqrt(2.0));
+}
+
+double chiSquarePValue(const double chi2, const int dof) {
+    if (dof <= 0) return 1.0;
+
+    // Q(dof/2, chi2/2), built up two degrees of freedom at a time from the dof = 2 or dof = 1 case
+    const double half{ chi2 / 2.0 };
+    const bool even{ dof % 2 == 0 };
+    double term{ even ? std::exp(-half) : 2.0 * std::sqrt(half / M_PI) * std::exp(-half) };
+    double q{ even ? term : std::erfc(std::sqrt(half)) };
+    if (!even && dof > 1) q += term;
+
+    for (int k{ even ? 2 : 3 }; k < dof; k += 2) {
+        term *= half / (k / 2.0);
+        q += term;
+    }
+    return q;
+}
+
+
+namespace {
+    // Every engine result reduced to the two outcomes all of them report
+    std::array<size_t, 2> absorbedLeaked(const SimReuslts& r) {
+        return {r.absorbed, r.reflected + r.transmitted};
+    }
+
+    SimReuslts runStepped(const unsigned long numNeutrons, const std::vector<Material>& materials,
+                          const std::vector<const Volume*>& volumes, const Source& source, const std::uint32_t seed) {
+        Simulation sim(numNeutrons, materials, volumes, source, seed);
+        while (sim.getCounters().alive > 0) sim.step();
+        return {sim.getCounters().absorbed, sim.getCounters().leaked, 0};
+    }
+
+    template<EnableOptimizations opt>
+    SimReuslts runFast(const unsigned long numNeutrons, const Material& mat, const double slabSize, const Source& source,
+                       RunContext& context, const std::uint32_t seed) {
+        Pcg32 gen{ seed };
+        return fastSimulation<opt>(numNeutrons, mat, slabSize, source, context, gen);
+    }
+
+    class Suite {
+    public:
+        // Observed successes against an exact probability
+        void analytic(const std::string& name, const size_t successes, const size_t trials, const double p,
+                      const bool required = true) {
+            zScore(name, binomialZScore(successes, trials, p), required);
+        }
+
+        void zScore(const std::string& name, const double z, const bool required = true) {
+            const double pValue{ normalPValue(z) };
+            checks.push_back({name, "z", z, pValue, pValue >= validationSignificance, required});
+        }
+
+        // Two engines on the same problem, outcome counts per category
+        void agree(const std::string& name, const std::span<const size_t> a, const std::span<const size_t> b,
+                   const bool required = true) {
+            int dof{};
+            const double chi2{ chiSquareHomogeneity(a, b, dof) };
+            const double pValue{ chiSquarePValue(chi2, dof) };
+            checks.push_back({name, "chi2", chi2, pValue, pValue >= validationSignificance, required});
+        }
+
+        // Results that must hold exactly, not just on average
+        void exact(const std::string& name, const bool holds) {
+            checks.push_back({name, "exact", 0.0, holds ? 1.0 : 0.0, holds});
+        }
+
+        std::vector<ValidationCheck> checks;
+    };
+}
+
+
+std::vector<ValidationCheck> runValidationSuite(const unsigned long numHistories, const std::uint32_t seed) {
+    Suite suite;
+    RunContext context{};
+    const Boundary noBoundary{};
+    const Source beam{ Source::point(TwoVec{0.0, 0.0}) };
+
+    // Pure absorbers: every collision absorbs, so the leaked fraction is the uncollided one
+    {
+        const double crossSec{ 0.5 };
+        const double thickness{ 4.0 };
+        const double transmission{ std::exp(-crossSec * thickness) };
+
+        const Material absorber{crossSec, 1.0, LEAD};
+        const Slab slab(0.0, thickness);
+        const std::vector<Material> materials{ absorber };
+        const std::vector<const Volume*> volumes{ &slab };
+
+        const SimReuslts fast{ runFast<NO_OPT>(numHistories, absorber, thickness, beam, context, seed) };
+        suite.analytic("absorber slab e^-St, fastSimulation", fast.transmitted, numHistories, transmission);
+
+        const SimReuslts fastOpt{ runFast<OPT>(numHistories, absorber, thickness, beam, context, seed) };
+        suite.analytic("absorber slab e^-St, fastSimulation OPT", fastOpt.transmitted, numHistories, transmission, false);
+
+        Pcg32 gen{ seed };
+        const SimReuslts analog{ volumeSimulation(numHistories, absorber, slab, beam, noBoundary, gen) };
+        suite.analytic("absorber slab e^-St, volumeSimulation", analog.reflected, numHistories, transmission);
+
+        gen.seed(seed);
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, materials, volumes, beam, noBoundary, gen) };
+        suite.analytic("absorber slab e^-St, woodCockSimulation", woodcock.reflected, numHistories, transmission);
+
+        const SimReuslts stepped{ runStepped(numHistories, materials, volumes, beam, seed) };
+        suite.analytic("absorber slab e^-St, Simulation", stepped.reflected, numHistories, transmission);
+    }
+
+    // Two absorbers in a row: the Woodcock engines sample with the majorant and must reject
+    // exactly enough tentative collisions in the thinner one to give e^-(S1 t1 + S2 t2)
+    {
+        const Material thin{0.2, 1.0, WATER};
+        const Material thick{1.0, 1.0, LEAD};
+        const Slab slab1(0.0, 3.0);
+        const Slab slab2(3.0, 5.0);
+        const std::vector<Material> materials{ thin, thick };
+        const std::vector<const Volume*> volumes{ &slab1, &slab2 };
+        const double transmission{ std::exp(-(0.2 * 3.0 + 1.0 * 2.0)) };
+
+        Pcg32 gen{ seed };
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, materials, volumes, beam, noBoundary, gen) };
+        suite.analytic("two absorbers e^-(S1t1+S2t2), woodCockSimulation", woodcock.reflected, numHistories, transmission);
+
+        constexpr TwoSlabStackGeometry stack{0.0, 3.0, 5.0};
+        const RegionMaterials<2> regions{ {MaterialConstants(thin), MaterialConstants(thick)} };
+        gen.seed(seed);
+        const SimReuslts specialized{ specializedWoodCockSimulation(numHistories, stack, regions, beam, gen) };
+        suite.analytic("two absorbers e^-(S1t1+S2t2), specialized", specialized.reflected, numHistories, transmission);
+
+        const SimReuslts stepped{ runStepped(numHistories, materials, volumes, beam, seed) };
+        suite.analytic("two absorbers e^-(S1t1+S2t2), Simulation", stepped.reflected, numHistories, transmission);
+    }
+
+    // Isotropic point source at the centre of an absorbing disc, every path to the edge is R long
+    {
+        const double crossSec{ 0.3 };
+        const double radius{ 5.0 };
+        const double escape{ std::exp(-crossSec * radius) };
+
+        const Material absorber{crossSec, 1.0, LEAD};
+        const Circle disc(radius, 0.0, 0.0);
+        const std::vector<Material> materials{ absorber };
+        const std::vector<const Volume*> volumes{ &disc };
+        const Source centre{ Source::point(TwoVec{0.0, 0.0}).isotropic() };
+
+        Pcg32 gen{ seed };
+        const SimReuslts analog{ volumeSimulation(numHistories, absorber, disc, centre, noBoundary, gen) };
+        suite.analytic("absorber disc e^-SR, volumeSimulation", analog.reflected, numHistories, escape);
+
+        gen.seed(seed);
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, materials, volumes, centre, noBoundary, gen) };
+        suite.analytic("absorber disc e^-SR, woodCockSimulation", woodcock.reflected, numHistories, escape);
+    }
+
+    // Infinite medium: inside a reflective box nothing can leak, so every neutron is absorbed
+    {
+        const Material graphite{0.40, 0.095 / 100.0, GRAPHITE};
+        const Slab slab(-10.0, 10.0);
+        const std::vector<Material> materials{ graphite };
+        const std::vector<const Volume*> volumes{ &slab };
+        const Boundary box(TwoVec{-10.0, -10.0}, TwoVec{10.0, 10.0}, REFLECTIVE, REFLECTIVE);
+        const unsigned long count{ numHistories / 100 };
+
+        Pcg32 gen{ seed };
+        const SimReuslts analog{ volumeSimulation(count, graphite, slab, beam, box, gen) };
+        suite.exact("reflective box absorbs all, volumeSimulation", analog.absorbed == count);
+
+        gen.seed(seed);
+        const SimReuslts woodcock{ woodCockSimulation(count, materials, volumes, beam, box, gen) };
+        suite.exact("reflective box absorbs all, woodCockSimulation", woodcock.absorbed == count);
+    }
+
+    // -log(u) is an exponential flight length with mean and variance 1. fastLog is checked on the
+    // same numbers, so the paired difference shows its bias far more sharply than a second sample.
+    {
+        Pcg32 gen{ seed };
+        std::uniform_real_distribution dist(0.0, 1.0);
+        double sum{};
+        double diffSum{};
+        double diffSum2{};
+        for (unsigned long i{}; i < numHistories; i++) {
+            const double u{ dist(gen) };
+            const double diff{ std::log(u) - fastLog(u) };
+            sum += -std::log(u);
+            diffSum += diff;
+            diffSum2 += diff * diff;
+        }
+        const double n{ static_cast<double>(numHistories) };
+        const double diffMean{ diffSum / n };
+        const double diffSigma{ std::sqrt((diffSum2 / n - diffMean * diffMean) / n) };
+
+        suite.zScore("mean flight length, std::log", (sum / n - 1.0) * std::sqrt(n));
+        suite.zScore("mean flight length, fastLog - std::log", diffMean / diffSigma, false);
+    }
+
+    // Moments of the deflection cosine against exact planar values. The uniform law has to match
+    // the isotropic fast path a null law takes (E[cos] = 0, E[cos^2] = 1/2) and hydrogen deflects
+    // uniformly within +-pi/2 (E[cos] = 2/pi, E[cos^2] = 1/2). The engine comparisons below
+    // cannot see this, a law that is wrong the same way in every engine agrees with itself.
+    {
+        const ScatteringLaw uniform{};
+        const ScatteringLaw hydrogen{ ScatteringLaw::elastic(1.0) };
+
+        auto moments = [&](const std::string& name, const ScatteringLaw* law, const double meanCos, const double meanCos2) {
+            Pcg32 gen{ seed };
+            std::uniform_real_distribution dist(0.0, 1.0);
+            double sum{};
+            double sum2{};
+            double sum4{};
+            for (unsigned long i{}; i < numHistories; i++) {
+                const double c{ scatterDirection(law, TwoVec{1.0, 0.0}, gen, dist).x };
+                sum += c;
+                sum2 += c * c;
+                sum4 += c * c * c * c;
+            }
+            const double n{ static_cast<double>(numHistories) };
+            const double m1{ sum / n };
+            const double m2{ sum2 / n };
+            suite.zScore(name + " E[cos]", (m1 - meanCos) / std::sqrt((m2 - m1 * m1) / n));
+            suite.zScore(name + " E[cos^2]", (m2 - meanCos2) / std::sqrt((sum4 / n - m2 * m2) / n));
+        };
+
+        moments("isotropic fast path", nullptr, 0.0, 0.5);
+        moments("ScatteringLaw()", &uniform, 0.0, 0.5);
+        moments("ScatteringLaw::elastic(1)", &hydrogen, 2.0 / M_PI, 0.5);
+    }
+
+    // Scattering problems have no closed form, so the engines are compared with each other
+    {
+        const Material water{3.47, 0.642 / 100.0, WATER};
+        const double thickness{ 2.0 };
+        const Slab slab(0.0, thickness);
+        const std::vector<Material> materials{ water };
+        const std::vector<const Volume*> volumes{ &slab };
+
+        // Different seeds per engine, equal streams would make the samples correlated
+        const SimReuslts fast{ runFast<NO_OPT>(numHistories, water, thickness, beam, context, seed) };
+        const SimReuslts fastOpt{ runFast<OPT>(numHistories, water, thickness, beam, context, seed + 1) };
+        const std::array<size_t, 3> fastCounts{ fast.absorbed, fast.reflected, fast.transmitted };
+        const std::array<size_t, 3> fastOptCounts{ fastOpt.absorbed, fastOpt.reflected, fastOpt.transmitted };
+        suite.agree("water slab, fastSimulation vs OPT", fastCounts, fastOptCounts, false);
+
+        Pcg32 gen{ seed + 2 };
+        const SimReuslts analog{ volumeSimulation(numHistories, water, slab, beam, noBoundary, gen) };
+        gen.seed(seed + 3);
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, materials, volumes, beam, noBoundary, gen) };
+        const SimReuslts stepped{ runStepped(numHistories, materials, volumes, beam, seed + 4) };
+
+        constexpr SingleSlabGeometry single{0.0, 2.0};
+        const RegionMaterials<1> regions{ {MaterialConstants(water)} };
+        gen.seed(seed + 5);
+        const SimReuslts specialized{ specializedWoodCockSimulation(numHistories, single, regions, beam, gen) };
+
+        suite.agree("water slab, fastSimulation vs volumeSimulation", absorbedLeaked(fast), absorbedLeaked(analog));
+        suite.agree("water slab, volumeSimulation vs woodCockSimulation", absorbedLeaked(analog), absorbedLeaked(woodcock));
+        suite.agree("water slab, volumeSimulation vs specialized", absorbedLeaked(analog), absorbedLeaked(specialized));
+        suite.agree("water slab, volumeSimulation vs Simulation", absorbedLeaked(analog), absorbedLeaked(stepped));
+
+        // Strongly forward peaked scattering (hydrogen) through the analog and the Woodcock paths
+        const Material hydrogenous{3.47, 0.642 / 100.0, WATER,
+                                   std::make_shared<const ScatteringLaw>(ScatteringLaw::elastic(1.0))};
+        const std::vector<Material> hydrogenousMaterials{ hydrogenous };
+        gen.seed(seed + 6);
+        const SimReuslts analogLaw{ volumeSimulation(numHistories, hydrogenous, slab, beam, noBoundary, gen) };
+        gen.seed(seed + 7);
+        const SimReuslts woodcockLaw{ woodCockSimulation(numHistories, hydrogenousMaterials, volumes, beam, noBoundary, gen) };
+        suite.agree("anisotropic water slab, volumeSimulation vs woodCockSimulation",
+                    absorbedLeaked(analogLaw), absorbedLeaked(woodcockLaw));
+    }
+
+    // Two different materials, where the fictitious collision rejection actually matters
+    {
+        const Material water{3.47, 0.642 / 100.0, WATER};
+        const Material lead{0.38, 1.389 / 100.0, LEAD};
+        const Slab slab1(0.0, 1.0);
+        const Slab slab2(1.0, 6.0);
+        const std::vector<Material> materials{ water, lead };
+        const std::vector<const Volume*> volumes{ &slab1, &slab2 };
+
+        Pcg32 gen{ seed };
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, materials, volumes, beam, noBoundary, gen) };
+        const SimReuslts stepped{ runStepped(numHistories, materials, volumes, beam, seed + 1) };
+
+        constexpr TwoSlabStackGeometry stack{0.0, 1.0, 6.0};
+        const RegionMaterials<2> regions{ {MaterialConstants(water), MaterialConstants(lead)} };
+        gen.seed(seed + 2);
+        const SimReuslts specialized{ specializedWoodCockSimulation(numHistories, stack, regions, beam, gen) };
+
+        suite.agree("water + lead, woodCockSimulation vs specialized", absorbedLeaked(woodcock), absorbedLeaked(specialized));
+        suite.agree("water + lead, woodCockSimulation vs Simulation", absorbedLeaked(woodcock), absorbedLeaked(stepped));
+    }
+
+    // Periodic sides make the box an infinite medium just like reflective ones, nothing leaks
+    {
+        const Material graphite{0.40, 0.095 / 100.0, GRAPHITE};
+        const Slab slab(-10.0, 10.0);
+        const std::vector<Material> materials{ graphite };
+        const std::vector<const Volume*> volumes{ &slab };
+        const Boundary box(TwoVec{-10.0, -10.0}, TwoVec{10.0, 10.0}, PERIODIC, PERIODIC);
+        const unsigned long count{ numHistories / 100 };
+
+        Pcg32 gen{ seed };
+        const SimReuslts analog{ volumeSimulation(count, graphite, slab, beam, box, gen) };
+        suite.exact("periodic box absorbs all, volumeSimulation", analog.absorbed == count);
+
+        gen.seed(seed);
+        const SimReuslts woodcock{ woodCockSimulation(count, materials, volumes, beam, box, gen) };
+        suite.exact("periodic box absorbs all, woodCockSimulation", woodcock.absorbed == count);
+    }
+
+    // Half disc as a CSG intersection, isotropic source on its flat side: the half of the neutrons
+    // flying away from it leave at once, the other half have R of absorber ahead of them
+    {
+        const double crossSec{ 0.3 };
+        const double radius{ 5.0 };
+        const double escape{ 0.5 + 0.5 * std::exp(-crossSec * radius) };
+
+        const Material absorber{crossSec, 1.0, LEAD};
+        const CSGRegion halfDisc(CSGExpr::circle(radius, 0.0, 0.0) & CSGExpr::halfPlane(-1.0, 0.0, 0.0));
+        const std::vector<Material> materials{ absorber };
+        const std::vector<const Volume*> volumes{ &halfDisc };
+        const Source centre{ Source::point(TwoVec{0.0, 0.0}).isotropic() };
+
+        Pcg32 gen{ seed };
+        const SimReuslts analog{ volumeSimulation(numHistories, absorber, halfDisc, centre, noBoundary, gen) };
+        suite.analytic("CSG half disc (1+e^-SR)/2, volumeSimulation", analog.reflected, numHistories, escape);
+
+        gen.seed(seed);
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, materials, volumes, centre, noBoundary, gen) };
+        suite.analytic("CSG half disc (1+e^-SR)/2, woodCockSimulation", woodcock.reflected, numHistories, escape);
+    }
+
+    // Lattices of absorbing pins in an absorbing fill. A beam along a row of cells through the pin
+    // centres crosses 2r of pin and pitch - 2r of fill per cell, so it sees a fixed optical depth.
+    {
+        const double pitch{ 1.0 };
+        const double pinRadius{ 0.3 };
+        const Material pinMaterial{1.0, 1.0, LEAD};
+        const Material fillMaterial{0.2, 1.0, WATER};
+        const Circle pin(pinRadius, 0.0, 0.0);
+        const Universe cell({&pin}, {pinMaterial}, fillMaterial);
+        const double pinDepth{ pinMaterial.getCrossSec() * 2.0 * pinRadius };
+        const double fillDepth{ fillMaterial.getCrossSec() * (pitch - 2.0 * pinRadius) };
+
+        // Four cells from x = 0, beam through the middle of the second row
+        const RectLattice rect(TwoVec{0.0, -2.0}, pitch, 4, 4, cell);
+        const std::vector<Material> rectMaterials{ Material{} };
+        const std::vector<const Volume*> rectVolumes{ &rect };
+        const Source rowBeam{ Source::point(TwoVec{0.0, -1.5}) };
+        const double rectTransmission{ std::exp(-4.0 * (pinDepth + fillDepth)) };
+
+        Pcg32 gen{ seed };
+        const SimReuslts woodcock{ woodCockSimulation(numHistories, rectMaterials, rectVolumes, rowBeam, noBoundary, gen) };
+        suite.analytic("rect lattice row e^-tau, woodCockSimulation", woodcock.reflected, numHistories, rectTransmission);
+
+        const SimReuslts stepped{ runStepped(numHistories, rectMaterials, rectVolumes, rowBeam, seed) };
+        suite.analytic("rect lattice row e^-tau, Simulation", stepped.reflected, numHistories, rectTransmission);
+
+        // Three rings, beam from the centre cell out along its row: half a cell and then two more
+        const HexLattice hex(TwoVec{0.0, 0.0}, pitch, 3, cell);
+        const std::vector<const Volume*> hexVolumes{ &hex };
+        const double hexTransmission{ std::exp(-2.5 * (pinDepth + fillDepth)) };
+
+        gen.seed(seed);
+        const SimReuslts hexWoodcock{ woodCockSimulation(numHistories, rectMaterials, hexVolumes, beam, noBoundary, gen) };
+        suite.analytic("hex lattice row e^-tau, woodCockSimulation", hexWoodcock.reflected, numHistories, hexTransmission);
+    }
+
+    // Source shapes and cones, each against the probability of landing in a known quarter or half
+    {
+        std::vector<TwoVec> positions(numHistories);
+        std::vector<TwoVec> directions(numHistories);
+        std::uniform_real_distribution dist(0.0, 1.0);
+
+        auto sampleAll = [&](const Source& source) {
+            Pcg32 gen{ seed };
+            source.sample(positions.data(), directions.data(), numHistories, gen, dist);
+        };
+        auto countIf = [](const std::vector<TwoVec>& values, auto&& predicate) {
+            return static_cast<size_t>(std::count_if(values.begin(), values.end(), predicate));
+        };
+
+        sampleAll(Source::line(TwoVec{0.0, 0.0}, TwoVec{4.0, 0.0}));
+        suite.analytic("line source, first quarter of the segment", countIf(positions, [](const TwoVec& p) { return p.x < 1.0; }),
+                       numHistories, 0.25);
+
+        sampleAll(Source::area(TwoVec{0.0, 0.0}, TwoVec{2.0, 4.0}));
+        suite.analytic("area source, lower left quadrant",
+                       countIf(positions, [](const TwoVec& p) { return p.x < 1.0 && p.y < 2.0; }), numHistories, 0.25);
+
+        const Circle disc(2.0, 1.0, 1.0);
+        sampleAll(Source::inVolume(disc));
+        const auto radius = [](const TwoVec& p) { return std::hypot(p.x - 1.0, p.y - 1.0); };
+        suite.exact("volume source, every neutron inside",
+                    countIf(positions, [&](const TwoVec& p) { return radius(p) <= 2.0; }) == numHistories);
+        suite.analytic("volume source, inner disc of half the radius",
+                       countIf(positions, [&](const TwoVec& p) { return radius(p) < 1.0; }), numHistories, 0.25);
+
+        const double halfAngle{ 0.6 };
+        sampleAll(Source::point(TwoVec{0.0, 0.0}).cone(TwoVec{0.0, 1.0}, halfAngle));
+        const auto offAxis = [](const TwoVec& d) { return std::abs(std::atan2(d.x, d.y)); };
+        suite.exact("cone source, every direction within the half angle",
+                    countIf(directions, [&](const TwoVec& d) { return offAxis(d) <= halfAngle + 1e-12; }) == numHistories);
+        suite.analytic("cone source, within half the half angle",
+                       countIf(directions, [&](const TwoVec& d) { return offAxis(d) < halfAngle / 2.0; }), numHistories, 0.5);
+    }
+
+    // Tabulated laws against their planar moments. Legendre {1, a1} is p(theta) ~ 1 + 3 a1 cos(theta),
+    // E[cos] = 3 a1 / 2. The CDF with a quarter of the weight backwards has E[cos] = (3/4 - 1/4) / (pi/2).
+    {
+        const ScatteringLaw legendre{ ScatteringLaw::fromLegendre({1.0, 0.2}) };
+        const ScatteringLaw tabulated{ ScatteringLaw::fromTabulatedCdf({-1.0, 0.0, 1.0}, {0.0, 0.25, 1.0}) };
+
+        auto meanCosine = [&](const std::string& name, const ScatteringLaw& law, const double expected) {
+            Pcg32 gen{ seed };
+            std::uniform_real_distribution dist(0.0, 1.0);
+            double sum{};
+            double sum2{};
+            for (unsigned long i{}; i < numHistories; i++) {
+                const double c{ law.scatter(TwoVec{1.0, 0.0}, gen, dist).x };
+                sum += c;
+                sum2 += c * c;
+            }
+            const double n{ static_cast<double>(numHistories) };
+            const double m1{ sum / n };
+            suite.zScore(name + " E[cos]", (m1 - expected) / std::sqrt((sum2 / n - m1 * m1) / n));
+        };
+
+        meanCosine("ScatteringLaw::fromLegendre({1, 0.2})", legendre, 0.3);
+        meanCosine("ScatteringLaw::fromTabulatedCdf", tabulated, 1.0 / M_PI);
+    }
+
+    // The dispatcher has to pick the specialisation and give the same answer as the generic engine
+    {
+        const Material water{3.47, 0.642 / 100.0, WATER};
+        const Circle disc(3.0, 0.0, 0.0);
+        const std::vector<Material> materials{ water };
+        const std::vector<const Volume*> volumes{ &disc };
+        const Source centre{ Source::point(TwoVec{0.0, 0.0}).isotropic() };
+        const unsigned long count{ numHistories / 10 };
+
+        const char* engine{ nullptr };
+        Pcg32 gen{ seed };
+        const SimReuslts dispatched{ dispatchSimulation(count, materials, volumes, centre, context, gen, &engine) };
+        gen.seed(seed + 1);
+        const SimReuslts generic{ woodCockSimulation(count, materials, volumes, centre, noBoundary, gen) };
+
+        suite.exact("water disc, dispatchSimulation picks single circle", std::string(engine) == "single circle");
+        suite.agree("water disc, dispatchSimulation vs woodCockSimulation", absorbedLeaked(dispatched), absorbedLeaked(generic));
+
+        const Rectanle box(TwoVec{-2.0, -1.0}, TwoVec{3.0, 1.5});
+        const std::vector<const Volume*> boxVolumes{ &box };
+        gen.seed(seed + 2);
+        const SimReuslts boxDispatched{ dispatchSimulation(count, materials, boxVolumes, centre, context, gen, &engine) };
+        gen.seed(seed + 3);
+        const SimReuslts boxGeneric{ woodCockSimulation(count, materials, boxVolumes, centre, noBoundary, gen) };
+
+        suite.exact("water box, dispatchSimulation picks single rectangle", std::string(engine) == "single rectangle");
+        suite.agree("water box, dispatchSimulation vs woodCockSimulation", absorbedLeaked(boxDispatched), absorbedLeaked(boxGeneric));
+    }
+
+    // Batched drivers: batches have fixed streams, so the totals must not depend on how many
+    // workers or ranks share them, and batch streams must sit exactly batchStride apart
+    {
+        const Material water{3.47, 0.642 / 100.0, WATER};
+        const Slab slab(0.0, 2.0);
+        const BatchJob job{ [&](const size_t count, Pcg32& gen, RunContext& batchContext) {
+            return volumeSimulation(count, water, slab, beam, noBoundary, batchContext, gen);
+        } };
+        const BatchPlan plan{ numHistories, 256 };
+
+        WorkStealingScheduler one(1, plan.batchSize);
+        WorkStealingScheduler four(4, plan.batchSize);
+        const SimReuslts oneWorker{ one.run(numHistories, seed, job).totals };
+        const SimReuslts fourWorkers{ four.run(numHistories, seed, job).totals };
+        suite.exact("scheduler, 1 and 4 workers give the same totals",
+                    absorbedLeaked(oneWorker) == absorbedLeaked(fourWorkers));
+
+        const SimReuslts oneRank{ runLocalMultiProcess(1, plan, seed, job).totals };
+        const SimReuslts threeRanks{ runLocalMultiProcess(3, plan, seed, job).totals };
+        suite.exact("distributed, 1 and 3 ranks give the same totals", absorbedLeaked(oneRank) == absorbedLeaked(threeRanks));
+        suite.exact("distributed and scheduler give the same totals", absorbedLeaked(oneRank) == absorbedLeaked(oneWorker));
+
+        Pcg32 gen{ seed + 1 };
+        const SimReuslts single{ volumeSimulation(numHistories, water, slab, beam, noBoundary, gen) };
+        suite.agree("water slab, batched streams vs one stream", absorbedLeaked(oneWorker), absorbedLeaked(single));
+
+        constexpr size_t manyBatches{ 50000 };
+        bool spaced{ true };
+        for (const size_t b : {size_t{0}, size_t{1}, manyBatches / 2, manyBatches - 2})
+            spaced = spaced && batchGenerator(seed, b + 1, manyBatches).drawsSince(batchGenerator(seed, b, manyBatches)) ==
+                               batchStride(manyBatches);
+        suite.exact("batch streams are batchStride apart", spaced);
+    }
+
+    return suite.checks;
+}
+
+bool printValidationReport(const std::vector<ValidationCheck>& checks) {
+    size_t failed{};
+    size_t deviating{};
+    for (const auto& c : checks) {
+        if (!c.passed && c.required) failed++;
+        if (!c.passed && !c.required) deviating++;
+        std::cout << (c.passed ? "[PASS] " : c.required ? "[FAIL] " : "[DIFF] ") << std::left << std::setw(64) << c.name << std::right
+                  << std::setw(6) << c.statistic << " = " << std::setw(9) << std::setprecision(4) << c.value
+                  << "  p = " << std::setprecision(3) << c.pValue << '\n';
+    }
+    std::cout << checks.size() - failed - deviating << '/' << checks.size() << " checks passed";
+    if (deviating > 0) std::cout << ", " << deviating << " approximations differ from the exact physics";
+    std::cout << '\n';
+    return failed == 0;
+}
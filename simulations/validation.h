@@ -0,0 +1,47 @@
+// Statistical checks of every engine against analytic results and against each other
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "../utils/types.h"
+
+// One comparison: the test statistic (a z-score or a chi-square), its p-value and whether it passed.
+// Checks of approximations that change the physics on purpose (the OPT modes) are not required,
+// they are reported so the size of the change is visible but do not fail the suite.
+struct ValidationCheck {
+    std::string name;
+    std::string statistic;
+    double value;
+    double pValue;
+    bool passed;
+    bool required{ true };
+};
+
+// Runs are seeded, so a check gives the same answer every time and a failure is a change in
+// the physics rather than bad luck. Checks fail below this p-value.
+constexpr double validationSignificance{ 1e-3 };
+
+// z-score of k successes in n trials against an expected probability p
+double binomialZScore(size_t successes, size_t trials, double p);
+
+// Pearson chi-square for two samples of counts over the same categories having the same
+// distribution. Categories empty in both are dropped, dof is set to the remaining count - 1.
+double chiSquareHomogeneity(std::span<const size_t> a, std::span<const size_t> b, int& dof);
+
+// Two sided p-value of a standard normal z
+double normalPValue(double z);
+
+// Upper tail of the chi-square distribution, closed form for integer degrees of freedom
+double chiSquarePValue(double chi2, int dof);
+
+// Pure absorbers against e^{-Σt} in slabs, discs, CSG regions and lattices, reflective and
+// periodic boxes against total absorption, fastLog's mean flight length, the source shapes,
+// moments of the scattering laws, scattering problems across all engines and optimisation
+// modes, the dispatcher against the generic engine, and the batched drivers against splits.
+std::vector<ValidationCheck> runValidationSuite(unsigned long numHistories = 100000, std::uint32_t seed = 12345);
+
+// Prints one line per check, returns true if all required ones passed
+bool printValidationReport(const std::vector<ValidationCheck>& checks);
@@ -0,0 +1,138 @@
+// Bump allocator over one big mapping, so repeated runs reuse already faulted-in pages
+#pragma once
+
+#include <new>
+#include <span>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+#endif
+
+class Arena {
+public:
+    explicit Arena(const size_t capacityBytes) : capacity(roundUp(capacityBytes, hugePageSize)) {
+        base = map(capacity, hugePages);
+    }
+
+    ~Arena() {
+        releaseOverflow();
+        unmap(base, capacity);
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Cache line aligned, uninitialised storage for count objects of a trivial type. A request
+    // that does not fit gets a mapping of its own, and the next reset() grows the arena to cover
+    // it, so a run only ever pays for outgrowing the arena once.
+    template<typename T>
+    std::span<T> allocate(const size_t count) {
+        const size_t start{ roundUp(offset, cacheLine) };
+        const size_t bytes{ count * sizeof(T) };
+        if (start + bytes > capacity) return { reinterpret_cast<T*>(allocateOverflow(bytes)), count };
+
+        offset = start + bytes;
+        return { reinterpret_cast<T*>(base + start), count };
+    }
+
+    // Touches every page so the memory is backed now, on the calling thread's NUMA node
+    void prefault() { std::memset(base, 0, capacity); }
+
+    // Everything allocated so far is handed out again by the next allocations
+    void reset() {
+        offset = 0;
+        if (overflow.empty()) return;
+
+        const size_t grown{ capacity + overflowBytes };
+        releaseOverflow();
+        unmap(base, capacity);
+        capacity = grown;
+        base = map(capacity, hugePages);
+    }
+
+    size_t used() const { return offset + overflowBytes; }
+    size_t getCapacity() const { return capacity; }
+    bool usesHugePages() const { return hugePages; }
+
+private:
+    static constexpr size_t hugePageSize{ size_t{2} << 20 };
+    static constexpr size_t cacheLine{ 64 };
+
+    static constexpr size_t roundUp(const size_t n, const size_t to) { return (n + to - 1) / to * to; }
+
+    static std::byte* map(const size_t bytes, bool& huge) {
+        huge = false;
+#if defined(__unix__) || defined(__APPLE__)
+    #if defined(__linux__)
+        // Explicit huge pages only work when the system has some reserved, otherwise fall back below
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            huge = true;
+            return static_cast<std::byte*>(p);
+        }
+    #endif
+        void* q = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (q == MAP_FAILED) throw std::bad_alloc();
+    #if defined(__linux__)
+        // Ask for transparent huge pages instead
+        huge = madvise(q, bytes, MADV_HUGEPAGE) == 0;
+    #endif
+        return static_cast<std::byte*>(q);
+#else
+        return static_cast<std::byte*>(::operator new(bytes, std::align_val_t{hugePageSize}));
+#endif
+    }
+
+    static void unmap(std::byte* p, const size_t bytes) {
+#if defined(__unix__) || defined(__APPLE__)
+        munmap(p, bytes);
+#else
+        ::operator delete(p, std::align_val_t{hugePageSize});
+#endif
+    }
+
+    std::byte* allocateOverflow(const size_t bytes) {
+        const size_t size{ roundUp(std::max<size_t>(bytes, 1), hugePageSize) };
+        bool huge{};
+        overflow.push_back({ map(size, huge), size });
+        overflowBytes += size;
+        return overflow.back().first;
+    }
+
+    void releaseOverflow() {
+        for (const auto& [p, size] : overflow) unmap(p, size);
+        overflow.clear();
+        overflowBytes = 0;
+    }
+
+    std::byte* base{ nullptr };
+    size_t capacity;
+    size_t offset{ 0 };
+    bool hugePages{ false };
+
+    // Mappings for requests that did not fit, kept until the next reset()
+    std::vector<std::pair<std::byte*, size_t>> overflow;
+    size_t overflowBytes{ 0 };
+};
+
+// Owns the memory of a series of simulation runs on one thread. Engines taking a context call
+// beginRun() and carve their particle and scratch buffers from arena(), so back to back runs
+// reuse pages that are already faulted in. Parallel drivers give every worker its own context,
+// so workers never share or contend for scratch memory.
+class RunContext {
+public:
+    explicit RunContext(const size_t capacityBytes = size_t{64} << 20) : mainArena(capacityBytes) {}
+
+    // Call at the start of every run, the buffers of the previous run are reused
+    void beginRun() { mainArena.reset(); }
+
+    Arena& arena() { return mainArena; }
+
+private:
+    Arena mainArena;
+};
@@ -1,26 +1,33 @@
 #pragma once
 
 #include <limits>
+#include <memory>
 #include "types.h"
+#include "scattering.h"
 
 class Material{
 public:
     // Creates a 'Vacuum' material
     Material() : crossSection(0.0), absorptionProbability(0.0),
-        meanFreePath(std::numeric_limits<double>::max()), type(VACUUM) {}
+        meanFreePath(std::numeric_limits<double>::infinity()), type(VACUUM) {}
 
-    Material(const double crossSec, const double absProb, const MaterialTypes type) :
-        crossSection(crossSec), absorptionProbability(absProb), meanFreePath(1.0 / absProb), type(type) {}
+    // A null scattering law means isotropic scattering in the lab frame
+    Material(const double crossSec, const double absProb, const MaterialTypes type,
+             std::shared_ptr<const ScatteringLaw> scattering = nullptr) :
+        crossSection(crossSec), absorptionProbability(absProb), meanFreePath(1.0 / crossSec), type(type),
+        scattering(std::move(scattering)) {}
 
     double getCrossSec() const { return crossSection; }
     double getAbsorptionProb() const { return absorptionProbability; }
-    double getMeanFreePath() const { return 1.0 / crossSection; }
+    double getMeanFreePath() const { return meanFreePath; }
     MaterialTypes getMaterialType() const { return type; }
+    const ScatteringLaw* getScatteringLaw() const { return scattering.get(); }
 
 private:
     double crossSection;
     double absorptionProbability;
     double meanFreePath;
     MaterialTypes type;
+    std::shared_ptr<const ScatteringLaw> scattering;
 
 };
\ No newline at end of file
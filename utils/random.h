@@ -0,0 +1,83 @@
+// Random number generator shared by every engine
+#pragma once
+
+#include <cstdint>
+
+// PCG32 (XSH RR, M. O'Neill, pcg-random.org): a 64-bit LCG with a permuted 32-bit output.
+// About as cheap as minstd_rand but with a 2^64 period and jump-ahead in O(log n), which is
+// what lets the batch drivers hand every batch its own disjoint block of one stream.
+class Pcg32 {
+public:
+    using result_type = std::uint32_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xffffffffu; }
+
+    explicit Pcg32(const std::uint64_t seed = 0x853c49e6748fea9bULL, const std::uint64_t stream = 0xda3e39cb94b95bdbULL)
+        : state(0), increment((stream << 1) | 1) {
+        this->seed(seed);
+    }
+
+    // Restarts the same stream from a new seed
+    void seed(const std::uint64_t seed) {
+        state = 0;
+        (*this)();
+        state += seed;
+        (*this)();
+    }
+
+    result_type operator()() {
+        const std::uint64_t old{ state };
+        state = old * multiplier + increment;
+        const auto xorShifted{ static_cast<std::uint32_t>(((old >> 18) ^ old) >> 27) };
+        const auto rotation{ static_cast<std::uint32_t>(old >> 59) };
+        return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31u));
+    }
+
+    // Same as delta calls to operator(), by composing the LCG step with itself
+    void advance(std::uint64_t delta) {
+        std::uint64_t stepMult{ multiplier };
+        std::uint64_t stepPlus{ increment };
+        std::uint64_t accMult{ 1 };
+        std::uint64_t accPlus{ 0 };
+        for (; delta > 0; delta >>= 1) {
+            if (delta & 1) {
+                accMult *= stepMult;
+                accPlus = accPlus * stepMult + stepPlus;
+            }
+            stepPlus = (stepMult + 1) * stepPlus;
+            stepMult *= stepMult;
+        }
+        state = accMult * state + accPlus;
+    }
+
+    void discard(const std::uint64_t n) { advance(n); }
+
+    // Draws taken since start, an earlier copy of this generator. Recovered bit by bit from the
+    // two states, so it costs at most 64 steps whatever the distance.
+    std::uint64_t drawsSince(const Pcg32& start) const {
+        std::uint64_t current{ start.state };
+        std::uint64_t stepMult{ multiplier };
+        std::uint64_t stepPlus{ increment };
+        std::uint64_t bit{ 1 };
+        std::uint64_t distance{ 0 };
+        while (current != state && bit != 0) {
+            if ((current & bit) != (state & bit)) {
+                current = current * stepMult + stepPlus;
+                distance |= bit;
+            }
+            bit <<= 1;
+            stepPlus = (stepMult + 1) * stepPlus;
+            stepMult *= stepMult;
+        }
+        return distance;
+    }
+
+    friend bool operator==(const Pcg32& a, const Pcg32& b) { return a.state == b.state && a.increment == b.increment; }
+
+private:
+    static constexpr std::uint64_t multiplier{ 6364136223846793005ULL };
+
+    std::uint64_t state;
+    std::uint64_t increment;
+};
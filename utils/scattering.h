@@ -0,0 +1,183 @@
+// Tabulated angular distributions for anisotropic (lab frame) scattering
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include "types.h"
+#include "random.h"
+#include "mathOps.h"
+
+// Distribution of the deflection angle theta in [0, pi] within the plane of the simulation,
+// with either sign equally likely. It is stored as a histogram of equal width bins in theta and
+// sampled through a Walker alias table, so every draw costs two uniforms and no search regardless
+// of how finely the law is tabulated. A flat histogram is the same uniform direction as
+// generate_isotropic_2vec.
+//
+// Laws given in terms of the 3D scattering cosine mu are mapped onto the plane by using their
+// density per unit solid angle, f(mu), as the density in theta: p(theta) ~ f(cos theta). This
+// drops the sin(theta) solid angle factor, which the plane does not have, so an isotropic f stays
+// isotropic in the plane.
+class ScatteringLaw {
+public:
+    // Isotropic law, mostly useful as a reference
+    ScatteringLaw() : ScatteringLaw(std::vector<double>(1, 1.0)) {}
+
+    // Legendre expansion f(mu) = sum_l (2l+1)/2 * coeffs[l] * P_l(mu), coeffs[0] is normalised to 1
+    static ScatteringLaw fromLegendre(const std::vector<double>& coeffs, const size_t numBins = 64) {
+        std::vector<double> probs(numBins);
+        constexpr int samplesPerBin{ 16 };
+        const double width{ M_PI / numBins };
+
+        for (size_t k{}; k < numBins; k++) {
+            // Midpoint rule inside each bin, negative lobes of truncated expansions are clipped
+            double sum{};
+            for (int s{}; s < samplesPerBin; s++) {
+                const double mu{ std::cos(width * (k + (s + 0.5) / samplesPerBin)) };
+                double pPrev{ 1.0 };
+                double pCurr{ mu };
+                double f{ 0.5 * coeffs[0] };
+                for (size_t l{ 1 }; l < coeffs.size(); l++) {
+                    f += (2.0 * l + 1.0) / 2.0 * coeffs[l] * pCurr;
+                    const double pNext{ ((2.0 * l + 1.0) * mu * pCurr - l * pPrev) / (l + 1.0) };
+                    pPrev = pCurr;
+                    pCurr = pNext;
+                }
+                sum += std::max(f, 0.0);
+            }
+            probs[k] = sum;
+        }
+        return ScatteringLaw(probs);
+    }
+
+    // Piecewise linear CDF of mu through the points (mu[i], cdf[i]), mu increasing from -1 to 1.
+    // Its slope is the density f(mu), which is mapped onto theta like the other 3D laws.
+    static ScatteringLaw fromTabulatedCdf(const std::vector<double>& mu, const std::vector<double>& cdf,
+                                          const size_t numBins = 64) {
+        auto densityAt = [&](const double m) {
+            const auto it = std::upper_bound(mu.begin(), mu.end(), m);
+            if (it == mu.begin() || it == mu.end()) return 0.0;
+            const size_t i = it - mu.begin();
+            return (cdf[i] - cdf[i - 1]) / (mu[i] - mu[i - 1]);
+        };
+
+        std::vector<double> probs(numBins);
+        for (size_t k{}; k < numBins; k++)
+            probs[k] = std::max(densityAt(std::cos(M_PI * (k + 0.5) / numBins)), 0.0);
+        return ScatteringLaw(probs);
+    }
+
+    // Elastic scattering off a nucleus of mass ratio A >= 1 (A = 1 for hydrogen) which is
+    // isotropic in the centre of mass frame, worked out with planar kinematics: the centre of mass
+    // angle is uniform in [0, pi] and tan(theta_lab) = sin(theta_cm) / (1/A + cos(theta_cm)).
+    static ScatteringLaw elastic(const double massRatio, const size_t numBins = 64) {
+        const double A{ massRatio };
+        auto labAngle = [A](const double thetaCM) {
+            return std::atan2(std::sin(thetaCM), 1.0 / A + std::cos(thetaCM));
+        };
+
+        // theta_lab is monotonic in theta_cm, so CDF_lab(t) = theta_cm(t) / pi found by bisection
+        auto cdfAt = [&](const double t) {
+            if (t >= labAngle(M_PI)) return 1.0;
+            double lo{ 0.0 };
+            double hi{ M_PI };
+            for (int it{}; it < 60; it++) {
+                const double mid{ 0.5 * (lo + hi) };
+                if (labAngle(mid) < t) lo = mid;
+                else hi = mid;
+            }
+            return 0.5 * (lo + hi) / M_PI;
+        };
+
+        std::vector<double> probs(numBins);
+        for (size_t k{}; k < numBins; k++)
+            probs[k] = cdfAt(M_PI * (k + 1) / numBins) - cdfAt(M_PI * k / numBins);
+        return ScatteringLaw(probs);
+    }
+
+    // Samples the cosine and the signed sine of the deflection angle
+    double sampleCosine(Pcg32& gen, std::uniform_real_distribution<double>& dist, double& sinTheta) const {
+        // First uniform picks the bin and decides the alias, second the position in the bin and the side
+        const double u1{ dist(gen) * numBins };
+        const size_t bin{ std::min(static_cast<size_t>(u1), numBins - 1) };
+        const size_t chosen{ (u1 - bin) < threshold[bin] ? bin : alias[bin] };
+
+        const double u2{ 2.0 * dist(gen) };
+        const double side{ u2 < 1.0 ? 1.0 : -1.0 };
+        const double frac{ u2 < 1.0 ? u2 : u2 - 1.0 };
+
+        const double theta{ binWidth * (chosen + frac) };
+        sinTheta = side * std::sin(theta);
+        return std::cos(theta);
+    }
+
+    // Rotates the current direction by a sampled deflection angle
+    TwoVec scatter(const TwoVec& dir, Pcg32& gen, std::uniform_real_distribution<double>& dist) const {
+        double s{};
+        const double c{ sampleCosine(gen, dist, s) };
+        return { dir.x * c - dir.y * s, dir.x * s + dir.y * c };
+    }
+
+    // New x direction cosine for the 1D slab engine, where the y component is only known up to its sign
+    double scatterCosine(const double dirX, Pcg32& gen, std::uniform_real_distribution<double>& dist) const {
+        double s{};
+        const double c{ sampleCosine(gen, dist, s) };
+        return dirX * c + s * std::sqrt(std::max(0.0, 1.0 - dirX * dirX));
+    }
+
+    // Mean cosine of the planar deflection angle
+    double meanCosine() const { return averageCosine; }
+
+private:
+    explicit ScatteringLaw(const std::vector<double>& binProbs) : numBins(binProbs.size()), binWidth(M_PI / binProbs.size()),
+                                                                  threshold(binProbs.size()), alias(binProbs.size()) {
+        const double total{ std::accumulate(binProbs.begin(), binProbs.end(), 0.0) };
+
+        // theta is uniform inside a bin, so each bin contributes its exact average cosine
+        averageCosine = 0.0;
+        std::vector<double> scaled(numBins);
+        for (size_t k{}; k < numBins; k++) {
+            scaled[k] = binProbs[k] / total * numBins;
+            averageCosine += binProbs[k] / total * (std::sin(binWidth * (k + 1)) - std::sin(binWidth * k)) / binWidth;
+        }
+
+        // Vose's construction of the alias table
+        std::vector<size_t> small;
+        std::vector<size_t> large;
+        for (size_t k{}; k < numBins; k++)
+            (scaled[k] < 1.0 ? small : large).push_back(k);
+
+        while (!small.empty() && !large.empty()) {
+            const size_t s{ small.back() };
+            const size_t l{ large.back() };
+            small.pop_back();
+
+            threshold[s] = scaled[s];
+            alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        for (const size_t k : large) { threshold[k] = 1.0; alias[k] = k; }
+        for (const size_t k : small) { threshold[k] = 1.0; alias[k] = k; }
+    }
+
+    size_t numBins;
+    double binWidth;
+    double averageCosine;
+    std::vector<double> threshold;
+    std::vector<size_t> alias;
+};
+
+// Collision direction update shared by the engines: a null law keeps the isotropic fast path
+inline TwoVec scatterDirection(const ScatteringLaw* law, const TwoVec& dir,
+                               Pcg32& gen, std::uniform_real_distribution<double>& dist) {
+    if (law == nullptr) return generate_isotropic_2vec(gen, dist);
+    return law->scatter(dir, gen, dist);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <cmath>
 
 enum EnableOptimizations {
     NO_OPT=0,
@@ -11,6 +12,27 @@ enum ShapeType {
     CIRCLE=0,
     RECTANGLE=1,
     SLAB=2,
+    CSG=3,
+    LATTICE=4,
+};
+
+enum SourceShape {
+    POINT_SOURCE=0,
+    LINE_SOURCE=1,
+    AREA_SOURCE=2,
+    VOLUME_SOURCE=3,
+};
+
+enum AngularDistribution {
+    MONO_DIRECTIONAL=0,
+    CONE=1,
+    ISOTROPIC=2,
+};
+
+enum BoundaryCondition {
+    VACUUM_BOUNDARY=0,
+    REFLECTIVE=1,
+    PERIODIC=2,
 };
 
 enum MaterialTypes {
@@ -34,6 +56,15 @@ struct SimReuslts {
     size_t transmitted;
 };
 
+// Running totals of a stepped simulation, updated as events happen rather than recounted
+struct SimCounters {
+    size_t alive;
+    size_t absorbed;
+    size_t leaked;
+    size_t collisions; // real (non-fictitious) collisions
+    size_t steps;
+};
+
 
 class TwoVec {
 public: